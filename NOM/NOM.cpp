@@ -39,6 +39,9 @@
 #include "sbml/conversion/SBMLRuleConverter.h"
 #include "sbml/conversion/SBMLFunctionDefinitionConverter.h"
 
+#include <thread>
+#include <atomic>
+
 #ifdef WIN32
 #ifndef CYGWIN
 #define strdup _strdup
@@ -46,11 +49,17 @@
 #endif
 
 
-SBMLDocument* _oSBMLDocCPP = NULL;
-Model* _oModelCPP = NULL;
+// The model loaded into a NOM context and the error state of its last call
+struct NOMContext
+{
+	SBMLDocument* document;
+	Model* model;
+	int errorCode;
+	char *extendedErrorMessage;
+};
 
-int errorCode = 0;
-char *extendedErrorMessage = NULL;
+// The context of the functions that take none
+static NOMContext defaultContext = { NULL, NULL, 0, NULL };
 
 static const char *errorMessages[] = {
 	  "No Error", 
@@ -84,6 +93,24 @@ static const char *errorMessages[] = {
 
 static const char* zero = "0";
 
+// The consistency check categories in the order libSBML runs them, together
+// with the bits SBMLDocument::getApplicableValidators uses for them
+#define NUM_CONSISTENCY_CATEGORIES 7
+
+static const SBMLErrorCategory_t consistencyCategories[NUM_CONSISTENCY_CATEGORIES] = {
+	  LIBSBML_CAT_IDENTIFIER_CONSISTENCY
+	, LIBSBML_CAT_GENERAL_CONSISTENCY
+	, LIBSBML_CAT_SBO_CONSISTENCY
+	, LIBSBML_CAT_MATHML_CONSISTENCY
+	, LIBSBML_CAT_UNITS_CONSISTENCY
+	, LIBSBML_CAT_OVERDETERMINED_MODEL
+	, LIBSBML_CAT_MODELING_PRACTICE
+};
+
+static const unsigned char consistencyValidators[NUM_CONSISTENCY_CATEGORIES] = {
+	0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40
+};
+
 extern "C" {
 
 // -------------------------------------------------------------------------------------------
@@ -122,7 +149,7 @@ char* strCopySubstr(const char *str, int index, int count)
 }
 
 
-int validateInternal (const std::string &sbml)
+int validateInternal (NOMContext *ctx, const std::string &sbml)
 {
 	SBMLReader oReader;
 	SBMLDocument *oDoc = oReader.readSBMLFromString(sbml);
@@ -130,22 +157,22 @@ int validateInternal (const std::string &sbml)
 	{
 		stringstream oStream; 
 		oDoc->printErrors (oStream);
-		errorCode = 2;
-        free(extendedErrorMessage);
-		extendedErrorMessage = strdup(oStream.str().c_str());		
+		ctx->errorCode = 2;
+        free(ctx->extendedErrorMessage);
+		ctx->extendedErrorMessage = strdup(oStream.str().c_str());		
 		return -1;
 	}
 	delete oDoc;
 	return 0;
 }
 
-unsigned int getNumBoundarySpeciesInternal()
+unsigned int getNumBoundarySpeciesInternal(NOMContext *ctx)
 {
-	unsigned int nNumSpecies = _oModelCPP->getNumSpecies();
+	unsigned int nNumSpecies = ctx->model->getNumSpecies();
 	unsigned int nResult = 0;
 	for (unsigned int i = 0; i < nNumSpecies; i++)
 	{
-		Species *oSpecies = _oModelCPP->getSpecies(i);
+		Species *oSpecies = ctx->model->getSpecies(i);
 		if (oSpecies->getBoundaryCondition())
 		{
 			nResult++;
@@ -190,7 +217,7 @@ void checkForMissingNames(const ASTNode * node, vector< string> &results, vector
 	}
 }
 
-DLL_EXPORT int convertSBML(const char *inputModel, char **outputModel, int nLevel, int nVersion)
+DLL_EXPORT int nom_convertSBML(NOMContext *ctx, const char *inputModel, char **outputModel, int nLevel, int nVersion)
 {
 	SBMLDocument *oSBMLDoc = readSBMLFromString(inputModel);
 	Model *oModel = oSBMLDoc->getModel();
@@ -201,7 +228,7 @@ DLL_EXPORT int convertSBML(const char *inputModel, char **outputModel, int nLeve
 		oModel = NULL;
 		oSBMLDoc = NULL;
 
-		validateInternal(inputModel);
+		validateInternal(ctx, inputModel);
 	}
 
 	oSBMLDoc->getErrorLog()->clearLog();
@@ -215,7 +242,7 @@ DLL_EXPORT int convertSBML(const char *inputModel, char **outputModel, int nLeve
 		delete oSBMLDoc;
 		oSBMLDoc = NULL;
 		oModel = NULL;
-		errorCode = 26;
+		ctx->errorCode = 26;
 		return -1;
 		throw ("Conversion failed", oStream.str());		
 	}
@@ -227,22 +254,27 @@ DLL_EXPORT int convertSBML(const char *inputModel, char **outputModel, int nLeve
 	return 0;
 }
 
-void freeModel()
+DLL_EXPORT int convertSBML(const char *inputModel, char **outputModel, int nLevel, int nVersion)
+{
+	return nom_convertSBML(&defaultContext, inputModel, outputModel, nLevel, nVersion);
+}
+
+void freeModel(NOMContext *ctx)
 {
 	try
 	{
-		delete _oSBMLDocCPP;
+		delete ctx->document;
 	}
 	catch(...)
 	{
 	}
-	_oModelCPP = NULL;
-	_oSBMLDocCPP = NULL;
+	ctx->model = NULL;
+	ctx->document = NULL;
 
 }
 
 
-char* addMissingModifiersInternal(const string& sModel)
+char* addMissingModifiersInternal(NOMContext *ctx, const string& sModel)
 {
 	try
 	{
@@ -253,9 +285,9 @@ char* addMissingModifiersInternal(const string& sModel)
 	  delete d;
 	  //string newModel = convertSBML(sModel, 2, 1);
 	  char * outputModel[1];
-	  convertSBML(sModel.c_str(),outputModel, 2, 1);
+	  nom_convertSBML(ctx, sModel.c_str(),outputModel, 2, 1);
 	  string newModel = *outputModel;
-	  return addMissingModifiersInternal(newModel);
+	  return addMissingModifiersInternal(ctx, newModel);
 	}
 		try
 		{
@@ -373,106 +405,209 @@ char* addMissingModifiersInternal(const string& sModel)
 // -------------------------------------------------------------------------------------------
 
 
+DLL_EXPORT NOMContext* nom_context_create()
+{
+	NOMContext *ctx = new NOMContext();
+	ctx->document = NULL;
+	ctx->model = NULL;
+	ctx->errorCode = 0;
+	ctx->extendedErrorMessage = NULL;
+	return ctx;
+}
+
+DLL_EXPORT void nom_context_free(NOMContext *ctx)
+{
+	if (ctx == NULL || ctx == &defaultContext)
+		return;
+	freeModel(ctx);
+	free(ctx->extendedErrorMessage);
+	delete ctx;
+}
+
+DLL_EXPORT NOMContext* nom_default_context()
+{
+	return &defaultContext;
+}
+
 // Load SBML file into the NOM
-DLL_EXPORT int loadSBML(const char* sbmlStr)
+DLL_EXPORT int nom_loadSBML(NOMContext *ctx, const char* sbmlStr)
 {	
 	string arg = sbmlStr;
 
 	if (sbmlStr == "")
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	if (_oSBMLDocCPP != NULL || _oModelCPP != NULL)
+	if (ctx->document != NULL || ctx->model != NULL)
 	{
-		freeModel();
+		freeModel(ctx);
 	}
 
 	SBMLReader oReader;
-	_oSBMLDocCPP = oReader.readSBMLFromString(arg);
-	_oModelCPP = _oSBMLDocCPP->getModel();
+	ctx->document = oReader.readSBMLFromString(arg);
+	ctx->model = ctx->document->getModel();
 
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
 		if (arg.find("<?xml") == arg.npos)
 		{
 			string sSBML = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" + arg;
-			return loadSBML(sSBML.c_str());
+			return nom_loadSBML(ctx, sSBML.c_str());
 		}
 		ConversionProperties props;
 		props.addOption("sortRules", true, "sort rules");
-		_oSBMLDocCPP->convert(props);
-		return validateInternal(arg);
+		ctx->document->convert(props);
+		return validateInternal(ctx, arg);
 	}
     //Otherwise, this worked.
     return 0;
 }
 
+DLL_EXPORT int loadSBML(const char* sbmlStr)
+{
+	return nom_loadSBML(&defaultContext, sbmlStr);
+}
+
+// Parse SBML into a document without loading it into the NOM
+DLL_EXPORT SBMLDocument* readSBMLDocument(const char* sbmlStr)
+{
+	return readSBMLDocumentFromMemory(sbmlStr, strlen(sbmlStr));
+}
+
+// Parse SBML that need not be NUL terminated, e.g. a file mapped into memory
+DLL_EXPORT SBMLDocument* readSBMLDocumentFromMemory(const char* sbml, size_t length)
+{
+	string arg(sbml, length);
+
+	SBMLReader oReader;
+	SBMLDocument *oDoc = oReader.readSBMLFromString(arg);
+	if (oDoc->getModel() == NULL && arg.find("<?xml") == arg.npos)
+	{
+		delete oDoc;
+		string sSBML = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" + arg;
+		oDoc = oReader.readSBMLFromString(sSBML);
+	}
+	return oDoc;
+}
+
+// Parse an SBML file without loading it into the NOM
+DLL_EXPORT SBMLDocument* readSBMLDocumentFromFile(const char* fileName)
+{
+	SBMLReader oReader;
+	return oReader.readSBMLFromFile(fileName);
+}
+
+// Load an already parsed document into the NOM, the NOM takes ownership of it
+DLL_EXPORT int nom_loadSBMLDocument(NOMContext *ctx, SBMLDocument *oDoc)
+{
+	if (oDoc == NULL)
+	{
+		ctx->errorCode = 1;
+		return -1;
+	}
+
+	if (ctx->document != NULL || ctx->model != NULL)
+	{
+		freeModel(ctx);
+	}
+
+	ctx->document = oDoc;
+	ctx->model = ctx->document->getModel();
+
+	if (ctx->model == NULL)
+	{
+		ctx->errorCode = 2;
+		return -1;
+	}
+	return 0;
+}
+
+DLL_EXPORT int loadSBMLDocument(SBMLDocument *oDoc)
+{
+	return nom_loadSBMLDocument(&defaultContext, oDoc);
+}
+
 
 // Call this is if any method returns -1, it will return the error message string
-DLL_EXPORT const char *getError () 
+DLL_EXPORT const char *nom_getError (NOMContext *ctx) 
 {
-	if (extendedErrorMessage != NULL) {
-	   char *t = strconcat (errorMessages[errorCode], extendedErrorMessage);
+	if (ctx->extendedErrorMessage != NULL) {
+	   char *t = strconcat (errorMessages[ctx->errorCode], ctx->extendedErrorMessage);
 	   return t;
 	} else
-	   return errorMessages[errorCode];
+	   return errorMessages[ctx->errorCode];
 }
 
-DLL_EXPORT int hasInitialAmount (char *sId, bool *isInitialAmount)
+DLL_EXPORT const char *getError ()
+{
+	return nom_getError(&defaultContext);
+}
+
+DLL_EXPORT int nom_hasInitialAmount (NOMContext *ctx, char *sId, bool *isInitialAmount)
 {
 	string ssId = sId;
 
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;				
 	}
 
-	Species *oSpecies = _oModelCPP->getSpecies(ssId);
+	Species *oSpecies = ctx->model->getSpecies(ssId);
 	if (oSpecies != NULL) {
 		*isInitialAmount = oSpecies->isSetInitialAmount();
 		return 0;
 	}
 
-	errorCode = 14;
+	ctx->errorCode = 14;
 	return -1;
 	throw ("Invalid string name. The name is not a valid id/name of a floating / boundary species.");
 }
 
+DLL_EXPORT int hasInitialAmount (char *sId, bool *isInitialAmount)
+{
+	return nom_hasInitialAmount(&defaultContext, sId, isInitialAmount);
+}
 
 
-DLL_EXPORT int hasInitialConcentration (char *cId, int *hasInitial)
+
+DLL_EXPORT int nom_hasInitialConcentration (NOMContext *ctx, char *cId, int *hasInitial)
 {
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
 	string sId = cId;
 
-	Species *oSpecies = _oModelCPP->getSpecies(sId);
+	Species *oSpecies = ctx->model->getSpecies(sId);
 	if (oSpecies != NULL) {
 		*hasInitial = (int) oSpecies->isSetInitialConcentration();
 		return 0;
 	}
 
-	errorCode = 21;
+	ctx->errorCode = 21;
 	return -1;
 }
 
+DLL_EXPORT int hasInitialConcentration (char *cId, int *hasInitial)
+{
+	return nom_hasInitialConcentration(&defaultContext, cId, hasInitial);
+}
 
-DLL_EXPORT int getValue (char *sId, double *value)
+
+DLL_EXPORT int nom_getValue (NOMContext *ctx, char *sId, double *value)
 {
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	Species *oSpecies = _oModelCPP->getSpecies(sId);
+	Species *oSpecies = ctx->model->getSpecies(sId);
 	if (oSpecies != NULL)
 	{
 		if (oSpecies->isSetInitialAmount())
@@ -484,7 +619,7 @@ DLL_EXPORT int getValue (char *sId, double *value)
 		return 0;
 	}
 
-	Compartment *oCompartment = _oModelCPP->getCompartment(sId);
+	Compartment *oCompartment = ctx->model->getCompartment(sId);
 	if (oCompartment != NULL)
 	{
       if (oCompartment->isSetVolume())
@@ -494,7 +629,7 @@ DLL_EXPORT int getValue (char *sId, double *value)
       return 0;
 	}
 
-	Parameter *oParameter = _oModelCPP->getParameter(sId);
+	Parameter *oParameter = ctx->model->getParameter(sId);
 	if (oParameter != NULL)
 	{
       if (oParameter->isSetValue())
@@ -503,19 +638,24 @@ DLL_EXPORT int getValue (char *sId, double *value)
         *value = 0.0;
       return 0;
 	}
-	errorCode = 15;
+	ctx->errorCode = 15;
 	return -1;
 }
 
-DLL_EXPORT int setValue (char *sId, double dValue)
+DLL_EXPORT int getValue (char *sId, double *value)
+{
+	return nom_getValue(&defaultContext, sId, value);
+}
+
+DLL_EXPORT int nom_setValue (NOMContext *ctx, char *sId, double dValue)
 {
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	Species *oSpecies = _oModelCPP->getSpecies(sId);
+	Species *oSpecies = ctx->model->getSpecies(sId);
 	if (oSpecies != NULL)
 	{
 		if (oSpecies->isSetInitialAmount())
@@ -525,71 +665,205 @@ DLL_EXPORT int setValue (char *sId, double dValue)
 		return 0;
 	}
 
-	Compartment *oCompartment = _oModelCPP->getCompartment(sId);
+	Compartment *oCompartment = ctx->model->getCompartment(sId);
 	if (oCompartment != NULL)
 	{
 		oCompartment->setVolume(dValue);
 		return 0;
 	}
 
-	Parameter *oParameter = _oModelCPP->getParameter(sId);
+	Parameter *oParameter = ctx->model->getParameter(sId);
 	if (oParameter != NULL)
 	{
 		oParameter->setValue(dValue);
 		return 0;
 	}
 
-	errorCode = 13;
+	ctx->errorCode = 13;
 	return -1;
 }
 
-DLL_EXPORT int validate(const char *sbml)
+DLL_EXPORT int setValue (char *sId, double dValue)
+{
+	return nom_setValue(&defaultContext, sId, dValue);
+}
+
+DLL_EXPORT int nom_validate(NOMContext *ctx, const char *sbml)
 {
 	string sbmlStr = sbml;
 
 	SBMLReader oReader;
 	SBMLDocument *oDoc = oReader.readSBMLFromString(sbmlStr); 
+	int result = nom_validateDocument(ctx, oDoc);
+	delete oDoc;
+	return result;
+}
+
+DLL_EXPORT int validate(const char *sbml)
+{
+	return nom_validate(&defaultContext, sbml);
+}
+
+DLL_EXPORT int nom_validateDocument(NOMContext *ctx, SBMLDocument *oDoc)
+{
     if (oDoc->getErrorLog()->getNumFailsWithSeverity(LIBSBML_SEV_ERROR) > 0)
 	{
 		stringstream oStream; 
 		oDoc->printErrors (oStream);
-		errorCode = 2;
+		ctx->errorCode = 2;
 		string str = oStream.str();
-        free(extendedErrorMessage);
-		extendedErrorMessage = (char *) malloc (sizeof(char)*(str.length() + 1));
-		strcpy(extendedErrorMessage, str.c_str());		
+        free(ctx->extendedErrorMessage);
+		ctx->extendedErrorMessage = (char *) malloc (sizeof(char)*(str.length() + 1));
+		strcpy(ctx->extendedErrorMessage, str.c_str());		
 
 		//extendedErrorMessage = (char *) str.c_str();	
-		delete oDoc;
 		return -1;
 	}
 	return 0;
 }
 
-DLL_EXPORT int getNumErrors()
+DLL_EXPORT int validateDocument(SBMLDocument *oDoc)
+{
+	return nom_validateDocument(&defaultContext, oDoc);
+}
+
+DLL_EXPORT int nom_checkDocumentConsistency(NOMContext *ctx, SBMLDocument *oDoc)
+{
+	// the consistency failures are logged in the error log of the document
+	oDoc->checkConsistency();
+	return nom_validateDocument(ctx, oDoc);
+}
+
+DLL_EXPORT int checkDocumentConsistency(SBMLDocument *oDoc)
+{
+	return nom_checkDocumentConsistency(&defaultContext, oDoc);
+}
+
+// Runs the checks of one category on each of the document copies, the copies
+// are handed out through the shared counter
+static void checkConsistencyWorker(vector<SBMLDocument*> *copies, std::atomic<int> *next, std::atomic<bool> *failed)
+{
+	int index;
+	while ((index = (*next)++) < (int)copies->size())
+	{
+		try
+		{
+			(*copies)[index]->checkConsistency();
+		}
+		catch(...)
+		{
+			*failed = true;
+		}
+	}
+}
+
+DLL_EXPORT int nom_checkDocumentConsistencyParallel(NOMContext *ctx, SBMLDocument *oDoc, int numThreads)
+{
+	// the validators of SBML packages run on every checkConsistency call
+	// whatever categories are switched on, so with packages in the document
+	// each copy would report their errors again
+	if (oDoc->getNumPlugins() > 0)
+		return nom_checkDocumentConsistency(ctx, oDoc);
+
+	if (numThreads <= 0)
+		numThreads = (int)std::thread::hardware_concurrency();
+
+	// every enabled category gets its own copy of the document with only that
+	// category switched on, the copies are made up front so the workers never
+	// touch the shared document
+	unsigned char enabled = oDoc->getApplicableValidators();
+	vector<SBMLDocument*> copies;
+	for (int i = 0; i < NUM_CONSISTENCY_CATEGORIES; i++)
+	{
+		if ((enabled & consistencyValidators[i]) == 0) continue;
+
+		SBMLDocument *oCopy = oDoc->clone();
+		oCopy->getErrorLog()->clearLog();
+		for (int j = 0; j < NUM_CONSISTENCY_CATEGORIES; j++)
+		{
+			oCopy->setConsistencyChecks(consistencyCategories[j], i == j);
+		}
+		copies.push_back(oCopy);
+	}
+
+	if (numThreads > (int)copies.size())
+		numThreads = (int)copies.size();
+
+	std::atomic<int> next(0);
+	std::atomic<bool> failed(false);
+	vector<std::thread> workers;
+	for (int i = 1; i < numThreads; i++)
+	{
+		workers.push_back(std::thread(checkConsistencyWorker, &copies, &next, &failed));
+	}
+	checkConsistencyWorker(&copies, &next, &failed);
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+
+	if (failed)
+	{
+		for (size_t i = 0; i < copies.size(); i++)
+			delete copies[i];
+		return nom_checkDocumentConsistency(ctx, oDoc);
+	}
+
+	// merge in the serial order, and like the serial check stop after the
+	// first category that leaves errors in the log
+	SBMLErrorLog *oLog = oDoc->getErrorLog();
+	bool bStop = false;
+	for (size_t i = 0; i < copies.size(); i++)
+	{
+		SBMLErrorLog *oCopyLog = copies[i]->getErrorLog();
+		if (!bStop && oCopyLog->getNumErrors() > 0)
+		{
+			for (unsigned int j = 0; j < oCopyLog->getNumErrors(); j++)
+			{
+				oLog->add(*oCopyLog->getError(j));
+			}
+			bStop = oLog->getNumFailsWithSeverity(LIBSBML_SEV_ERROR) > 0;
+		}
+		delete copies[i];
+	}
+
+	return nom_validateDocument(ctx, oDoc);
+}
+
+DLL_EXPORT int checkDocumentConsistencyParallel(SBMLDocument *oDoc, int numThreads)
+{
+	return nom_checkDocumentConsistencyParallel(&defaultContext, oDoc, numThreads);
+}
+
+DLL_EXPORT int nom_getNumErrors(NOMContext *ctx)
 {
-	if (_oSBMLDocCPP == NULL)
+	if (ctx->document == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
-	return (int)_oSBMLDocCPP->getNumErrors();
+	return (int)ctx->document->getNumErrors();
 }
 
-DLL_EXPORT int getNthError (int index, int *line, int *column, int *errorId, char **errorType, char **errorMsg)
+DLL_EXPORT int getNumErrors()
+{
+	return nom_getNumErrors(&defaultContext);
+}
+
+DLL_EXPORT int nom_getNthError (NOMContext *ctx, int index, int *line, int *column, int *errorId, char **errorType, char **errorMsg)
 {
-	if (_oSBMLDocCPP == NULL)
+	if (ctx->document == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
-	unsigned int nErrors = _oSBMLDocCPP->getNumErrors();
+	unsigned int nErrors = ctx->document->getNumErrors();
 	if (index >= (int)nErrors) {
-		errorCode = 22;
+		ctx->errorCode = 22;
 		return -1;
 	}
 
-	const SBMLError* error = _oSBMLDocCPP->getError(index);
+	const SBMLError* error = ctx->document->getError(index);
 
 
 	string oResult;
@@ -611,120 +885,175 @@ DLL_EXPORT int getNthError (int index, int *line, int *column, int *errorId, cha
 	return 0;
 }
 
+DLL_EXPORT int getNthError (int index, int *line, int *column, int *errorId, char **errorType, char **errorMsg)
+{
+	return nom_getNthError(&defaultContext, index, line, column, errorId, errorType, errorMsg);
+}
 
-DLL_EXPORT int validateSBML(const char *cSBML)
+
+DLL_EXPORT int nom_validateSBML(NOMContext *ctx, const char *cSBML)
 {
 	string sSBML(cSBML);
 	if (sSBML == "")
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	return validateInternal(sSBML.c_str());
+	return validateInternal(ctx, sSBML.c_str());
 }
 
-DLL_EXPORT int getModelName (char **name)
+DLL_EXPORT int validateSBML(const char *cSBML)
+{
+	return nom_validateSBML(&defaultContext, cSBML);
+}
+
+DLL_EXPORT int nom_getModelName (NOMContext *ctx, char **name)
 {
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
-	*name = (char *) GET_NAME_IF_POSSIBLE(_oModelCPP).c_str();
+	*name = (char *) GET_NAME_IF_POSSIBLE(ctx->model).c_str();
 	return 0;
 }
 
+DLL_EXPORT int getModelName (char **name)
+{
+	return nom_getModelName(&defaultContext, name);
+}
 
-DLL_EXPORT int getModelId (char **Id)
+
+DLL_EXPORT int nom_getModelId (NOMContext *ctx, char **Id)
 {
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
-	*Id = (char *) GET_ID_IF_POSSIBLE(_oModelCPP).c_str();
+	*Id = (char *) GET_ID_IF_POSSIBLE(ctx->model).c_str();
 	return 0;
 }
 
-DLL_EXPORT int setModelId (char *cId)
+DLL_EXPORT int getModelId (char **Id)
+{
+	return nom_getModelId(&defaultContext, Id);
+}
+
+DLL_EXPORT int nom_setModelId (NOMContext *ctx, char *cId)
 {
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 	string sId = cId;
-	_oModelCPP->setId(sId);
+	ctx->model->setId(sId);
 	return 0;
 }
 
-DLL_EXPORT int getNumFunctionDefinitions()
+DLL_EXPORT int setModelId (char *cId)
+{
+	return nom_setModelId(&defaultContext, cId);
+}
+
+DLL_EXPORT int nom_getNumFunctionDefinitions(NOMContext *ctx)
 {	
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}	
-	return (int)_oModelCPP->getNumFunctionDefinitions();
+	return (int)ctx->model->getNumFunctionDefinitions();
 }
 
-DLL_EXPORT int getNumCompartments()
+DLL_EXPORT int getNumFunctionDefinitions()
 {
-	if (_oModelCPP == NULL)
+	return nom_getNumFunctionDefinitions(&defaultContext);
+}
+
+DLL_EXPORT int nom_getNumCompartments(NOMContext *ctx)
+{
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
-	return (int)_oModelCPP->getNumCompartments();
+	return (int)ctx->model->getNumCompartments();
 }
 
-DLL_EXPORT int getNumReactions()
+DLL_EXPORT int getNumCompartments()
+{
+	return nom_getNumCompartments(&defaultContext);
+}
+
+DLL_EXPORT int nom_getNumReactions(NOMContext *ctx)
 {
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
-	return (int)_oModelCPP->getNumReactions();
+	return (int)ctx->model->getNumReactions();
 }
 
-DLL_EXPORT int getNumFloatingSpecies()
+DLL_EXPORT int getNumReactions()
 {
-	if (_oModelCPP == NULL)
+	return nom_getNumReactions(&defaultContext);
+}
+
+DLL_EXPORT int nom_getNumFloatingSpecies(NOMContext *ctx)
+{
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return 0; 
 	}
-	int numSpecies = _oModelCPP->getNumSpecies();
-	int numBoundarySpecies = getNumBoundarySpeciesInternal();
+	int numSpecies = ctx->model->getNumSpecies();
+	int numBoundarySpecies = getNumBoundarySpeciesInternal(ctx);
 	int result = numSpecies - numBoundarySpecies;
 	return result;
 }
 
-DLL_EXPORT int getNumBoundarySpecies()
+DLL_EXPORT int getNumFloatingSpecies()
 {
-	if (_oModelCPP == NULL)
+	return nom_getNumFloatingSpecies(&defaultContext);
+}
+
+DLL_EXPORT int nom_getNumBoundarySpecies(NOMContext *ctx)
+{
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return 0;
 	}	
-	return (int)getNumBoundarySpeciesInternal();
+	return (int)getNumBoundarySpeciesInternal(ctx);
+}
+
+DLL_EXPORT int getNumBoundarySpecies()
+{
+	return nom_getNumBoundarySpecies(&defaultContext);
 }
 
 
-DLL_EXPORT int getNumGlobalParameters()
+DLL_EXPORT int nom_getNumGlobalParameters(NOMContext *ctx)
 {
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
-	return (int)_oModelCPP->getNumParameters();
+	return (int)ctx->model->getNumParameters();
 }
 
+DLL_EXPORT int getNumGlobalParameters()
+{
+	return nom_getNumGlobalParameters(&defaultContext);
+}
 
-DLL_EXPORT int getNthFunctionDefinition (int index, char** fnId, int *numArgs, char*** argList, char** body)
+
+DLL_EXPORT int nom_getNthFunctionDefinition (NOMContext *ctx, int index, char** fnId, int *numArgs, char*** argList, char** body)
 {
 	int n;
 	FunctionDefinition* fnDefn;
@@ -733,19 +1062,19 @@ DLL_EXPORT int getNthFunctionDefinition (int index, char** fnId, int *numArgs, c
 
 	fprintf (stderr, "Stage 1\n");
 
-	if(_oModelCPP == NULL)
+	if(ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	if(index < 0 || index >= (int)_oModelCPP->getNumFunctionDefinitions())
+	if(index < 0 || index >= (int)ctx->model->getNumFunctionDefinitions())
 	{
-		errorCode = 3;
+		ctx->errorCode = 3;
 		return -1;
 	}
 
-	fnDefn		= _oModelCPP->getFunctionDefinition(index);
+	fnDefn		= ctx->model->getFunctionDefinition(index);
 
 	fnMath		= SBML_formulaToString ( fnDefn->getBody() );
 
@@ -766,58 +1095,73 @@ DLL_EXPORT int getNthFunctionDefinition (int index, char** fnId, int *numArgs, c
 	return 0;
 }
 
-DLL_EXPORT int getNthCompartmentName (int nIndex, char **name)
+DLL_EXPORT int getNthFunctionDefinition (int index, char** fnId, int *numArgs, char*** argList, char** body)
+{
+	return nom_getNthFunctionDefinition(&defaultContext, index, fnId, numArgs, argList, body);
+}
+
+DLL_EXPORT int nom_getNthCompartmentName (NOMContext *ctx, int nIndex, char **name)
 {
-	if(_oModelCPP == NULL)
+	if(ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	if(nIndex < 0 || nIndex >= (int)_oModelCPP->getNumCompartments())
+	if(nIndex < 0 || nIndex >= (int)ctx->model->getNumCompartments())
 	{
-		errorCode = 4;
+		ctx->errorCode = 4;
 		return -1;
 	}
-	Compartment* oCompartment = _oModelCPP->getCompartment(nIndex);
+	Compartment* oCompartment = ctx->model->getCompartment(nIndex);
 	*name = (char *) GET_NAME_IF_POSSIBLE(oCompartment).c_str();
 	return 0;
 }
 
-DLL_EXPORT int getNthCompartmentId (int nIndex, char **Id)
+DLL_EXPORT int getNthCompartmentName (int nIndex, char **name)
+{
+	return nom_getNthCompartmentName(&defaultContext, nIndex, name);
+}
+
+DLL_EXPORT int nom_getNthCompartmentId (NOMContext *ctx, int nIndex, char **Id)
 {
-	if(_oModelCPP == NULL)
+	if(ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	if(nIndex < 0 || nIndex >= (int)_oModelCPP->getNumCompartments())
+	if(nIndex < 0 || nIndex >= (int)ctx->model->getNumCompartments())
 	{
-		errorCode = 4;
+		ctx->errorCode = 4;
 		return -1;
 	}
-	Compartment* oCompartment = _oModelCPP->getCompartment(nIndex);
+	Compartment* oCompartment = ctx->model->getCompartment(nIndex);
 	*Id = (char *) GET_ID_IF_POSSIBLE(oCompartment).c_str();
 	return 0;
 }
 
-DLL_EXPORT int getListOfFloatingSpeciesIds (char*** IdList, int *numFloat)
+DLL_EXPORT int getNthCompartmentId (int nIndex, char **Id)
 {
-	if(_oModelCPP == NULL)
+	return nom_getNthCompartmentId(&defaultContext, nIndex, Id);
+}
+
+DLL_EXPORT int nom_getListOfFloatingSpeciesIds (NOMContext *ctx, char*** IdList, int *numFloat)
+{
+	if(ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
 	int count = 0;
 	char *tmp;
-	*numFloat = getNumFloatingSpecies ();
+	*numFloat = nom_getNumFloatingSpecies(ctx);
 	*IdList = (char **) malloc (*numFloat);
 
-	for(unsigned i= 0; i < _oModelCPP->getNumSpecies(); i++)
+	for(unsigned i= 0; i < ctx->model->getNumSpecies(); i++)
 	{
-		Species *oSpecies = _oModelCPP->getSpecies (i);
+		Species *oSpecies = ctx->model->getSpecies (i);
 		if (!oSpecies->getBoundaryCondition())
 		{
 			tmp =  (char *) GET_ID_IF_POSSIBLE(oSpecies).c_str();
@@ -828,17 +1172,22 @@ DLL_EXPORT int getListOfFloatingSpeciesIds (char*** IdList, int *numFloat)
 	return 0;
 }
 
-DLL_EXPORT int getNthFloatingSpeciesName (int nIndex, char **name)
+DLL_EXPORT int getListOfFloatingSpeciesIds (char*** IdList, int *numFloat)
+{
+	return nom_getListOfFloatingSpeciesIds(&defaultContext, IdList, numFloat);
+}
+
+DLL_EXPORT int nom_getNthFloatingSpeciesName (NOMContext *ctx, int nIndex, char **name)
 {
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 	int nCount = 0;
-	for(unsigned int i = 0; i< _oModelCPP->getNumSpecies(); i++)
+	for(unsigned int i = 0; i< ctx->model->getNumSpecies(); i++)
 	{
-		Species *oSpecies = _oModelCPP->getSpecies(i);
+		Species *oSpecies = ctx->model->getSpecies(i);
 		if(!oSpecies->getBoundaryCondition())
 		{
 			if(nCount == nIndex)
@@ -852,22 +1201,27 @@ DLL_EXPORT int getNthFloatingSpeciesName (int nIndex, char **name)
 			}
 		}
 	}
-	errorCode = 5;
+	ctx->errorCode = 5;
 	return -1;
 }
 
-DLL_EXPORT int getNthFloatingSpeciesId (int nIndex, char** name)
+DLL_EXPORT int getNthFloatingSpeciesName (int nIndex, char **name)
 {
-	if (_oModelCPP == NULL)
+	return nom_getNthFloatingSpeciesName(&defaultContext, nIndex, name);
+}
+
+DLL_EXPORT int nom_getNthFloatingSpeciesId (NOMContext *ctx, int nIndex, char** name)
+{
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
 	int nCount = 0;
-	for(unsigned int i = 0; i< _oModelCPP->getNumSpecies(); i++)
+	for(unsigned int i = 0; i< ctx->model->getNumSpecies(); i++)
 	{
-		Species *oSpecies = _oModelCPP->getSpecies(i);
+		Species *oSpecies = ctx->model->getSpecies(i);
 		if(!oSpecies->getBoundaryCondition())
 		{
 			if(nCount == nIndex)
@@ -881,26 +1235,31 @@ DLL_EXPORT int getNthFloatingSpeciesId (int nIndex, char** name)
 			}
 		}
 	}
-	errorCode = 6;
+	ctx->errorCode = 6;
 	return -1;
 }
 
-DLL_EXPORT int getListOfBoundarySpeciesIds (char*** IdList, int *numBoundary)
+DLL_EXPORT int getNthFloatingSpeciesId (int nIndex, char** name)
+{
+	return nom_getNthFloatingSpeciesId(&defaultContext, nIndex, name);
+}
+
+DLL_EXPORT int nom_getListOfBoundarySpeciesIds (NOMContext *ctx, char*** IdList, int *numBoundary)
 {
 
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
 	int count = 0;
-	*numBoundary = getNumBoundarySpecies();
+	*numBoundary = nom_getNumBoundarySpecies(ctx);
 	*IdList = (char **) malloc (*numBoundary);
 
-	for(unsigned i= 0; i < _oModelCPP->getNumSpecies(); i++)
+	for(unsigned i= 0; i < ctx->model->getNumSpecies(); i++)
 	{
-		Species *oSpecies = _oModelCPP->getSpecies (i);
+		Species *oSpecies = ctx->model->getSpecies (i);
 		if (oSpecies->getBoundaryCondition())
 		{
 			(*IdList)[count] =  (char *) GET_ID_IF_POSSIBLE(oSpecies).c_str();
@@ -910,17 +1269,22 @@ DLL_EXPORT int getListOfBoundarySpeciesIds (char*** IdList, int *numBoundary)
 	return 0;
 }
 
-DLL_EXPORT int getNthBoundarySpeciesName (int nIndex, char **name)
+DLL_EXPORT int getListOfBoundarySpeciesIds (char*** IdList, int *numBoundary)
 {
-	if (_oModelCPP == NULL)
+	return nom_getListOfBoundarySpeciesIds(&defaultContext, IdList, numBoundary);
+}
+
+DLL_EXPORT int nom_getNthBoundarySpeciesName (NOMContext *ctx, int nIndex, char **name)
+{
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 	int nCount = 0;
-	for(unsigned int i = 0; i< _oModelCPP->getNumSpecies(); i++)
+	for(unsigned int i = 0; i< ctx->model->getNumSpecies(); i++)
 	{
-		Species *oSpecies = _oModelCPP->getSpecies(i);
+		Species *oSpecies = ctx->model->getSpecies(i);
 		if(oSpecies->getBoundaryCondition())
 		{
 			if(nCount == nIndex)
@@ -934,21 +1298,26 @@ DLL_EXPORT int getNthBoundarySpeciesName (int nIndex, char **name)
 			}
 		}
 	}
-	errorCode = 7;
+	ctx->errorCode = 7;
 	return -1;
 }
 
-DLL_EXPORT int getNthBoundarySpeciesId (int nIndex, char **name)
+DLL_EXPORT int getNthBoundarySpeciesName (int nIndex, char **name)
 {
-	if (_oModelCPP == NULL)
+	return nom_getNthBoundarySpeciesName(&defaultContext, nIndex, name);
+}
+
+DLL_EXPORT int nom_getNthBoundarySpeciesId (NOMContext *ctx, int nIndex, char **name)
+{
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 	int nCount = 0;
-	for(unsigned int i = 0; i< _oModelCPP->getNumSpecies(); i++)
+	for(unsigned int i = 0; i< ctx->model->getNumSpecies(); i++)
 	{
-		Species *oSpecies = _oModelCPP->getSpecies(i);
+		Species *oSpecies = ctx->model->getSpecies(i);
 		if(oSpecies->getBoundaryCondition())
 		{
 			if(nCount == nIndex)
@@ -962,207 +1331,252 @@ DLL_EXPORT int getNthBoundarySpeciesId (int nIndex, char **name)
 			}
 		}
 	}
-	errorCode = 8;
+	ctx->errorCode = 8;
 	return -1;
 
 }
 
-DLL_EXPORT int getCompartmentIdBySpeciesId (char *cId, char **compId)
+DLL_EXPORT int getNthBoundarySpeciesId (int nIndex, char **name)
+{
+	return nom_getNthBoundarySpeciesId(&defaultContext, nIndex, name);
+}
+
+DLL_EXPORT int nom_getCompartmentIdBySpeciesId (NOMContext *ctx, char *cId, char **compId)
 {
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
 	string sId = cId; 
 
-	Species* oSpecies = _oModelCPP->getSpecies(sId);
+	Species* oSpecies = ctx->model->getSpecies(sId);
 	if (oSpecies == NULL)
 	{
-		errorCode = 17;
+		ctx->errorCode = 17;
 		return -1;
 	}
 	*compId = (char *) oSpecies->getCompartment().c_str();
     return 0;
 }
 
-DLL_EXPORT int isReactionReversible(int arg, int *isReversible)
+DLL_EXPORT int getCompartmentIdBySpeciesId (char *cId, char **compId)
 {
-  if (_oModelCPP == NULL)
+	return nom_getCompartmentIdBySpeciesId(&defaultContext, cId, compId);
+}
+
+DLL_EXPORT int nom_isReactionReversible(NOMContext *ctx, int arg, int *isReversible)
+{
+  if (ctx->model == NULL)
   {
-	 errorCode = 1;
+	 ctx->errorCode = 1;
 	 return -1;
   }
   
-  if(arg >= (int) _oModelCPP->getNumReactions())
+  if(arg >= (int) ctx->model->getNumReactions())
   {
-	 errorCode = 10;
+	 ctx->errorCode = 10;
 	 return -1;
   }
-  *isReversible = _oModelCPP->getReaction(arg)->getReversible();
+  *isReversible = ctx->model->getReaction(arg)->getReversible();
   return 0;
 }
 
+DLL_EXPORT int isReactionReversible(int arg, int *isReversible)
+{
+	return nom_isReactionReversible(&defaultContext, arg, isReversible);
+}
 
-DLL_EXPORT int getNthReactionName (int nIndex, char **name)
+
+DLL_EXPORT int nom_getNthReactionName (NOMContext *ctx, int nIndex, char **name)
 {
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	if (nIndex >= (int)_oModelCPP->getNumReactions())
+	if (nIndex >= (int)ctx->model->getNumReactions())
 	{
-		errorCode = 11;
+		ctx->errorCode = 11;
 		return -1;
 	}
 
-	Reaction *oReaction = _oModelCPP->getReaction((unsigned int) nIndex);
+	Reaction *oReaction = ctx->model->getReaction((unsigned int) nIndex);
 	if (oReaction == NULL)
 	{
-		errorCode = 11;
+		ctx->errorCode = 11;
 		return -1;
 	}
 	*name = (char *) GET_NAME_IF_POSSIBLE(oReaction).c_str();
 	return 0;
 }
 
-DLL_EXPORT int getNthReactionId (int nIndex, char **Id)
+DLL_EXPORT int getNthReactionName (int nIndex, char **name)
+{
+	return nom_getNthReactionName(&defaultContext, nIndex, name);
+}
+
+DLL_EXPORT int nom_getNthReactionId (NOMContext *ctx, int nIndex, char **Id)
 {
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	if(nIndex >= (int)_oModelCPP->getNumReactions())
+	if(nIndex >= (int)ctx->model->getNumReactions())
 	{
-		errorCode = 11;
+		ctx->errorCode = 11;
 		return -1;
 	}
 
-	Reaction *oReaction = _oModelCPP->getReaction((unsigned int) nIndex);
+	Reaction *oReaction = ctx->model->getReaction((unsigned int) nIndex);
 	if (oReaction == NULL)
 	{
-		errorCode = 11;
+		ctx->errorCode = 11;
 		return -1;
 	}
 	*Id = (char *) GET_ID_IF_POSSIBLE(oReaction).c_str();
 	return 0;
 }
 
-DLL_EXPORT int getNumReactants (int arg)
+DLL_EXPORT int getNthReactionId (int nIndex, char **Id)
+{
+	return nom_getNthReactionId(&defaultContext, nIndex, Id);
+}
+
+DLL_EXPORT int nom_getNumReactants (NOMContext *ctx, int arg)
 {
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	return (int)_oModelCPP->getReaction(arg)->getNumReactants();;
+	return (int)ctx->model->getReaction(arg)->getNumReactants();;
 }
 
-DLL_EXPORT int getNumProducts (int arg)
+DLL_EXPORT int getNumReactants (int arg)
+{
+	return nom_getNumReactants(&defaultContext, arg);
+}
+
+DLL_EXPORT int nom_getNumProducts (NOMContext *ctx, int arg)
 {
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	return (int)_oModelCPP->getReaction(arg)->getNumProducts();;
+	return (int)ctx->model->getReaction(arg)->getNumProducts();;
 }
 
-DLL_EXPORT int getNthReactantName (int arg1, int arg2, char **name)
+DLL_EXPORT int getNumProducts (int arg)
+{
+	return nom_getNumProducts(&defaultContext, arg);
+}
+
+DLL_EXPORT int nom_getNthReactantName (NOMContext *ctx, int arg1, int arg2, char **name)
 {
 	ListOfSpeciesReferences* reactantsList;
 	SpeciesReference* reactant;
 	Reaction* r;
 
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	if(arg1 >= (int)_oModelCPP->getNumReactions())
+	if(arg1 >= (int)ctx->model->getNumReactions())
 	{
-		errorCode = 10;
+		ctx->errorCode = 10;
 		return -1;
 	}
 
-	r = _oModelCPP->getReaction(arg1);
+	r = ctx->model->getReaction(arg1);
 	reactantsList = r->getListOfReactants();
 
 	if(arg2 >= (int)reactantsList->size())
 	{
-		errorCode = 9;
+		ctx->errorCode = 9;
 		return -1;
 	}
 
 	reactant = r->getReactant(arg2);
 	if (reactant == NULL) {
-		errorCode = 9;
+		ctx->errorCode = 9;
 		return -1;
 	}
 	*name = (char *) reactant->getSpecies().c_str();
 	return 0;
 }
 
-DLL_EXPORT int getNthProductName (int arg1, int arg2, char **name)
+DLL_EXPORT int getNthReactantName (int arg1, int arg2, char **name)
+{
+	return nom_getNthReactantName(&defaultContext, arg1, arg2, name);
+}
+
+DLL_EXPORT int nom_getNthProductName (NOMContext *ctx, int arg1, int arg2, char **name)
 {
 	SpeciesReference* product;
 	Reaction* r;
 
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	if (arg1 >= (int)_oModelCPP->getNumReactions())
+	if (arg1 >= (int)ctx->model->getNumReactions())
 	{
-		errorCode = 10;
+		ctx->errorCode = 10;
 		return -1;
 	}
 
-	r = _oModelCPP->getReaction(arg1);
+	r = ctx->model->getReaction(arg1);
 
 	if (arg2 >= (int)(r->getNumProducts()))
 	{
-		errorCode = 11;
+		ctx->errorCode = 11;
 		return -1;
 	}
 
 	product = r->getProduct(arg2);
 	if (product == NULL) {
-		errorCode = 11;
+		ctx->errorCode = 11;
 		return -1;
 	}
 	*name = (char *) product->getSpecies().c_str();
 	return 0;
 }
 
-DLL_EXPORT int getKineticLaw (int index, char **kineticLaw)
+DLL_EXPORT int getNthProductName (int arg1, int arg2, char **name)
+{
+	return nom_getNthProductName(&defaultContext, arg1, arg2, name);
+}
+
+DLL_EXPORT int nom_getKineticLaw (NOMContext *ctx, int index, char **kineticLaw)
 {
 	Reaction* r;
 	KineticLaw* kl;
 
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	if(index >= (int)_oModelCPP->getNumReactions() || index < 0)
+	if(index >= (int)ctx->model->getNumReactions() || index < 0)
 	{
-		errorCode = 10;
+		ctx->errorCode = 10;
 		return -1;
 	}
 
-	r = _oModelCPP->getReaction(index);
+	r = ctx->model->getReaction(index);
 	kl = r->getKineticLaw();
 	if (kl == NULL)
 	{
@@ -1175,31 +1589,36 @@ DLL_EXPORT int getKineticLaw (int index, char **kineticLaw)
 	return 0;
 }
 
-DLL_EXPORT double getNthReactantStoichiometry (int arg1, int arg2)
+DLL_EXPORT int getKineticLaw (int index, char **kineticLaw)
+{
+	return nom_getKineticLaw(&defaultContext, index, kineticLaw);
+}
+
+DLL_EXPORT double nom_getNthReactantStoichiometry (NOMContext *ctx, int arg1, int arg2)
 {
 	double result;
 	ListOf* reactantsList;
 	SpeciesReference* reactant;
 	Reaction* r;
 
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	if(arg1 >= (int)_oModelCPP->getNumReactions())
+	if(arg1 >= (int)ctx->model->getNumReactions())
 	{
-		errorCode = 10;
+		ctx->errorCode = 10;
 		return -1;
 	}
 
-	r = _oModelCPP->getReaction(arg1);
+	r = ctx->model->getReaction(arg1);
 	reactantsList = r->getListOfReactants();
 
 	if(arg2 >= (int)ListOf_size(reactantsList))
 	{
-		errorCode = 9;
+		ctx->errorCode = 9;
 		return -1;
 	}
 
@@ -1208,31 +1627,36 @@ DLL_EXPORT double getNthReactantStoichiometry (int arg1, int arg2)
 	return result;
 }
 
-DLL_EXPORT double getNthProductStoichiometry (int arg1, int arg2)
+DLL_EXPORT double getNthReactantStoichiometry (int arg1, int arg2)
+{
+	return nom_getNthReactantStoichiometry(&defaultContext, arg1, arg2);
+}
+
+DLL_EXPORT double nom_getNthProductStoichiometry (NOMContext *ctx, int arg1, int arg2)
 {
 	double result;
 	ListOf* productsList;
 	SpeciesReference* product;
 	Reaction* r;
 
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	if (arg1 >= (int)_oModelCPP->getNumReactions())
+	if (arg1 >= (int)ctx->model->getNumReactions())
 	{
-		errorCode = 10;
+		ctx->errorCode = 10;
 		return -1;
 	}
 
-	r = _oModelCPP->getReaction(arg1);
+	r = ctx->model->getReaction(arg1);
 	productsList =  r->getListOfProducts();
 
 	if(arg2 >= (int)productsList->size())
 	{
-		errorCode = 11;
+		ctx->errorCode = 11;
 	}
 
 	product = (SpeciesReference* ) productsList->get(arg2);
@@ -1240,6 +1664,11 @@ DLL_EXPORT double getNthProductStoichiometry (int arg1, int arg2)
 	return result;
 }
 
+DLL_EXPORT double getNthProductStoichiometry (int arg1, int arg2)
+{
+	return nom_getNthProductStoichiometry(&defaultContext, arg1, arg2);
+}
+
 void changeTimeSymbol (ASTNode *node, const char* time) 
 { 
 	unsigned int c;
@@ -1548,58 +1977,70 @@ void promoteLocalParamToGlobal(SBMLDocument *oDoc, Model *oModelCPP)
 }
 
 
+DLL_EXPORT int nom_getParamPromotedSBML (NOMContext *ctx, const char *inSBML, char **outSBML)
+{
+	SBMLDocument *oSBMLDoc = readSBMLFromString(inSBML);
+
+	if (nom_promoteLocalParameters(ctx, oSBMLDoc) == -1)
+	{
+		delete oSBMLDoc;
+		return -1;
+	}
+
+	*outSBML = writeSBMLToString(oSBMLDoc);
+	delete oSBMLDoc;
+	return 0;
+}
+
 DLL_EXPORT int getParamPromotedSBML (const char *inSBML, char **outSBML)
 {
-	SBMLDocument *oSBMLDoc = NULL;
-	Model *oModel = NULL;
+	return nom_getParamPromotedSBML(&defaultContext, inSBML, outSBML);
+}
 
-	oSBMLDoc = readSBMLFromString(inSBML);
+DLL_EXPORT int nom_promoteLocalParameters (NOMContext *ctx, SBMLDocument *oSBMLDoc)
+{
 	if (oSBMLDoc->getLevel() == 1)
 		oSBMLDoc->setLevelAndVersion( 2, 1, false);
-	oModel = oSBMLDoc->getModel();
+	Model *oModel = oSBMLDoc->getModel();
 
 	if (oModel == NULL)
 	{	
-		errorCode = 2;
+		ctx->errorCode = 2;
 		return -1;
 	}
-	else
-	{
-		modifyKineticLaws(oSBMLDoc, oModel);
 
-		promoteLocalParamToGlobal(oSBMLDoc, oModel);
+	modifyKineticLaws(oSBMLDoc, oModel);
 
-		changeTimeSymbolModel(oModel, "time");
+	promoteLocalParamToGlobal(oSBMLDoc, oModel);
 
-		char *resultSBML = writeSBMLToString(oSBMLDoc);
+	changeTimeSymbolModel(oModel, "time");
+	return 0;
+}
 
-		delete oSBMLDoc;
-		oModel = NULL;
-		oSBMLDoc = NULL;
-		*outSBML = resultSBML;
-		return 0;
-	}
+DLL_EXPORT int promoteLocalParameters (SBMLDocument *oSBMLDoc)
+{
+	return nom_promoteLocalParameters(&defaultContext, oSBMLDoc);
 }
 
-DLL_EXPORT int getNumLocalParameters (int reactionIndex)
+DLL_EXPORT int nom_getNumLocalParameters (NOMContext *ctx, int reactionIndex)
 {
 	int result;
 	Reaction* r;
 	KineticLaw* kl;
 
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 2;
+		ctx->errorCode = 2;
 		return -1;
 	}
 
-	if(reactionIndex >= (int)_oModelCPP->getNumReactions() || reactionIndex < 0)
+	if(reactionIndex >= (int)ctx->model->getNumReactions() || reactionIndex < 0)
 	{
-		errorCode = 15;
+		ctx->errorCode = 15;
 		return -1;
 	}
 
-	r = _oModelCPP->getReaction(reactionIndex);
+	r = ctx->model->getReaction(reactionIndex);
 	kl = r->getKineticLaw();
 
 	if(kl == NULL)
@@ -1613,32 +2054,37 @@ DLL_EXPORT int getNumLocalParameters (int reactionIndex)
 	return result;
 }
 
-DLL_EXPORT int getNthLocalParameterName (int reactionIndex, int parameterIndex, char **sId)
+DLL_EXPORT int getNumLocalParameters (int reactionIndex)
+{
+	return nom_getNumLocalParameters(&defaultContext, reactionIndex);
+}
+
+DLL_EXPORT int nom_getNthLocalParameterName (NOMContext *ctx, int reactionIndex, int parameterIndex, char **sId)
 {
 	Reaction* r;
 	KineticLaw* kl;
 	ListOf* parametersList;
 	Parameter* parameter;
 
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 2;
+		ctx->errorCode = 2;
 		return -1;
 	}
 
-	if (reactionIndex >= (int)_oModelCPP->getNumReactions())
+	if (reactionIndex >= (int)ctx->model->getNumReactions())
 	{
-		errorCode = 15;
+		ctx->errorCode = 15;
 		return -1;
 	}
 
-	r = _oModelCPP->getReaction(reactionIndex);
+	r = ctx->model->getReaction(reactionIndex);
 	kl = r->getKineticLaw();
 	parametersList = kl->getListOfParameters();
 
 	if(parameterIndex >= (int)parametersList->size())
 	{
-		errorCode = 17;
+		ctx->errorCode = 17;
 		return -1;
 	}
 
@@ -1647,7 +2093,12 @@ DLL_EXPORT int getNthLocalParameterName (int reactionIndex, int parameterIndex,
 	return 0;
 }
 
-DLL_EXPORT int getNthLocalParameterId (int reactionIndex, int parameterIndex, char **sId)
+DLL_EXPORT int getNthLocalParameterName (int reactionIndex, int parameterIndex, char **sId)
+{
+	return nom_getNthLocalParameterName(&defaultContext, reactionIndex, parameterIndex, sId);
+}
+
+DLL_EXPORT int nom_getNthLocalParameterId (NOMContext *ctx, int reactionIndex, int parameterIndex, char **sId)
 {
 	string result;	
 	Reaction* r;
@@ -1655,25 +2106,25 @@ DLL_EXPORT int getNthLocalParameterId (int reactionIndex, int parameterIndex, ch
 	ListOf* parametersList;
 	Parameter* parameter;
 
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 2;
+		ctx->errorCode = 2;
 		return -1;
 	}
 
-	if (reactionIndex >= (int)_oModelCPP->getNumReactions())
+	if (reactionIndex >= (int)ctx->model->getNumReactions())
 	{
-		errorCode = 15;
+		ctx->errorCode = 15;
 		return -1;
 	}
 
-	r = _oModelCPP->getReaction(reactionIndex);
+	r = ctx->model->getReaction(reactionIndex);
 	kl = r->getKineticLaw();
 	parametersList = kl->getListOfParameters();
 
 	if (parameterIndex >= (int)parametersList->size())
 	{
-		errorCode = 17;
+		ctx->errorCode = 17;
 		return -1;
 	}
 
@@ -1683,27 +2134,32 @@ DLL_EXPORT int getNthLocalParameterId (int reactionIndex, int parameterIndex, ch
 	return 0;
 }
 
+DLL_EXPORT int getNthLocalParameterId (int reactionIndex, int parameterIndex, char **sId)
+{
+	return nom_getNthLocalParameterId(&defaultContext, reactionIndex, parameterIndex, sId);
+}
+
 
-DLL_EXPORT int getNthLocalParameterValue (int reactionIndex, int parameterIndex, double *value)
+DLL_EXPORT int nom_getNthLocalParameterValue (NOMContext *ctx, int reactionIndex, int parameterIndex, double *value)
 {
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 2;
+		ctx->errorCode = 2;
 		return -1;
 	}
 
-	if(reactionIndex < 0 || reactionIndex >= (int)_oModelCPP->getNumReactions())
+	if(reactionIndex < 0 || reactionIndex >= (int)ctx->model->getNumReactions())
 	{
-		errorCode = 15;
+		ctx->errorCode = 15;
 		return -1;
 	}
 
-	Reaction *oReaction = _oModelCPP->getReaction(reactionIndex);
+	Reaction *oReaction = ctx->model->getReaction(reactionIndex);
 	ListOfParameters *oList = oReaction->getKineticLaw()->getListOfParameters();
 
 	if(parameterIndex < 0 || parameterIndex >= (int)oList->size())
 	{
-		errorCode = 17;
+		ctx->errorCode = 17;
 		return -1;
 	}
 
@@ -1711,81 +2167,101 @@ DLL_EXPORT int getNthLocalParameterValue (int reactionIndex, int parameterIndex,
 	return 0;
 }
 
-DLL_EXPORT int getNthGlobalParameterName (int nIndex, char **name)
+DLL_EXPORT int getNthLocalParameterValue (int reactionIndex, int parameterIndex, double *value)
 {
-	if (_oModelCPP == NULL)
+	return nom_getNthLocalParameterValue(&defaultContext, reactionIndex, parameterIndex, value);
+}
+
+DLL_EXPORT int nom_getNthGlobalParameterName (NOMContext *ctx, int nIndex, char **name)
+{
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	if(nIndex >= (int)_oModelCPP->getNumParameters())
+	if(nIndex >= (int)ctx->model->getNumParameters())
 	{
-		errorCode = 12;
+		ctx->errorCode = 12;
 		return -1;
 	}
 
-	Parameter *oParameter = _oModelCPP->getParameter((unsigned int) nIndex);
+	Parameter *oParameter = ctx->model->getParameter((unsigned int) nIndex);
 	if (oParameter == NULL)
 	{
-		errorCode = 12;
+		ctx->errorCode = 12;
 		return -1;
 	}
 	*name = (char *) GET_NAME_IF_POSSIBLE(oParameter).c_str();
 	return 0;
 }
 
-DLL_EXPORT int getNthGlobalParameterId (int nIndex, char **Id)
+DLL_EXPORT int getNthGlobalParameterName (int nIndex, char **name)
+{
+	return nom_getNthGlobalParameterName(&defaultContext, nIndex, name);
+}
+
+DLL_EXPORT int nom_getNthGlobalParameterId (NOMContext *ctx, int nIndex, char **Id)
 {
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	if(nIndex >= (int)_oModelCPP->getNumParameters())
+	if(nIndex >= (int)ctx->model->getNumParameters())
 	{
-		errorCode = 12;
+		ctx->errorCode = 12;
 		return -1;
 	}
 
-	Parameter *oParameter = _oModelCPP->getParameter((unsigned int) nIndex);
+	Parameter *oParameter = ctx->model->getParameter((unsigned int) nIndex);
 	if (oParameter == NULL)
 	{
-		errorCode = 12;
+		ctx->errorCode = 12;
 		return -1;
 	}
 	*Id = (char *) GET_ID_IF_POSSIBLE(oParameter).c_str();
 	return 0;
 }
 
-DLL_EXPORT int getNumRules()
+DLL_EXPORT int getNthGlobalParameterId (int nIndex, char **Id)
+{
+	return nom_getNthGlobalParameterId(&defaultContext, nIndex, Id);
+}
+
+DLL_EXPORT int nom_getNumRules(NOMContext *ctx)
 {
 	int		result;
 
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
-	result	= _oModelCPP->getNumRules();
+	result	= ctx->model->getNumRules();
 
 	return result;
 }
 
-DLL_EXPORT int getNthRule (int nIndex, char **rule, int *ruleType)
+DLL_EXPORT int getNumRules()
+{
+	return nom_getNumRules(&defaultContext);
+}
+
+DLL_EXPORT int nom_getNthRule (NOMContext *ctx, int nIndex, char **rule, int *ruleType)
 {
 
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	Rule *oRule = _oModelCPP->getRule(nIndex);
+	Rule *oRule = ctx->model->getRule(nIndex);
 	if (oRule == NULL)
 	{
-		errorCode = 19;
+		ctx->errorCode = 19;
 	}
 
 	SBMLTypeCode_t type = (SBMLTypeCode_t) oRule->getTypeCode();
@@ -1829,37 +2305,47 @@ DLL_EXPORT int getNthRule (int nIndex, char **rule, int *ruleType)
 	return 0;
 }
 
+DLL_EXPORT int getNthRule (int nIndex, char **rule, int *ruleType)
+{
+	return nom_getNthRule(&defaultContext, nIndex, rule, ruleType);
+}
+
 
-DLL_EXPORT int getNumEvents()
+DLL_EXPORT int nom_getNumEvents(NOMContext *ctx)
 {
 	int		result;
 
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return 0;
 	}
-	result	= _oModelCPP->getNumEvents();
+	result	= ctx->model->getNumEvents();
 
 	return result;
 }
 
+DLL_EXPORT int getNumEvents()
+{
+	return nom_getNumEvents(&defaultContext);
+}
 
-DLL_EXPORT int getNthEvent (int arg, char **trigger, char **delay, char **lValue, char **rValue)
+
+DLL_EXPORT int nom_getNthEvent (NOMContext *ctx, int arg, char **trigger, char **delay, char **lValue, char **rValue)
 {
 	Event*			    event;
 	int					numEventAssignments;
 
-	if (_oModelCPP == NULL)
+	if (ctx->model == NULL)
 	{
-		errorCode = 1;
+		ctx->errorCode = 1;
 		return -1;
 	}
 
-	event = _oModelCPP->getEvent (arg);
+	event = ctx->model->getEvent (arg);
 	if(event == NULL)
 	{
-		errorCode = 20;
+		ctx->errorCode = 20;
 		return -1;
 	}
 
@@ -1895,7 +2381,12 @@ DLL_EXPORT int getNthEvent (int arg, char **trigger, char **delay, char **lValue
 	return 0;
 }
 
-DLL_EXPORT int convertMathMLToString (const char *mathMLStr, char **infix)
+DLL_EXPORT int getNthEvent (int arg, char **trigger, char **delay, char **lValue, char **rValue)
+{
+	return nom_getNthEvent(&defaultContext, arg, trigger, delay, lValue, rValue);
+}
+
+DLL_EXPORT int nom_convertMathMLToString (NOMContext *ctx, const char *mathMLStr, char **infix)
 {
 	char*				result;
 	const ASTNode_t*	ast_Node;
@@ -1919,28 +2410,33 @@ DLL_EXPORT int convertMathMLToString (const char *mathMLStr, char **infix)
 	ast_Node	= readMathMLFromString (mathMLStr);
 	if (ast_Node == NULL)
 	{
-		errorCode = 23;
+		ctx->errorCode = 23;
 		return -1;
 	}
 	result = SBML_formulaToString (ast_Node);
 
 	if (result == NULL)
 	{
-		errorCode = 23;
+		ctx->errorCode = 23;
 		return -1;
 	}
 	*infix = result;
     return 0;
 }
 
-DLL_EXPORT int convertStringToMathML (const char* infixStr, char **mathMLStr)
+DLL_EXPORT int convertMathMLToString (const char *mathMLStr, char **infix)
+{
+	return nom_convertMathMLToString(&defaultContext, mathMLStr, infix);
+}
+
+DLL_EXPORT int nom_convertStringToMathML (NOMContext *ctx, const char* infixStr, char **mathMLStr)
 {
 	char*			result;
 	ASTNode_t		*mtree_root;
 
 	mtree_root	= (ASTNode_t *) SBML_parseFormula (infixStr);
 	if (mtree_root == NULL) {
-		errorCode = 24;
+		ctx->errorCode = 24;
 		return -1;
 	}
 
@@ -1951,47 +2447,80 @@ DLL_EXPORT int convertStringToMathML (const char* infixStr, char **mathMLStr)
 	return 0;
 }
 
-DLL_EXPORT int addMissingModifiers (const char *inSBML, char **outSBML)
+DLL_EXPORT int convertStringToMathML (const char* infixStr, char **mathMLStr)
+{
+	return nom_convertStringToMathML(&defaultContext, infixStr, mathMLStr);
+}
+
+DLL_EXPORT int nom_addMissingModifiers (NOMContext *ctx, const char *inSBML, char **outSBML)
 {
 	string sModel = inSBML;
 
 	try
 	{
-		*outSBML = addMissingModifiersInternal(sModel);
+		*outSBML = addMissingModifiersInternal(ctx, sModel);
 		return 0;
 	}
 	catch(...)
 	{
-		errorCode = 15;
+		ctx->errorCode = 15;
 		return -1;
 	}
 
 }
 
-DLL_EXPORT int reorderRules (char **sbml)
+DLL_EXPORT int addMissingModifiers (const char *inSBML, char **outSBML)
+{
+	return nom_addMissingModifiers(&defaultContext, inSBML, outSBML);
+}
+
+DLL_EXPORT int nom_reorderRules (NOMContext *ctx, char **sbml)
 {
 	try
 	{
 		SBMLDocument *doc = readSBMLFromString(*sbml);
+		int ret = nom_reorderDocumentRules(ctx, doc);
+		char * string = doc->toSBML();
+		*sbml = string; 
+		delete doc;
+		return ret;
+	}
+	catch (...)
+	{
+		ctx->errorCode = 25;
+		return -1;
+	}
+}
+
+DLL_EXPORT int reorderRules (char **sbml)
+{
+	return nom_reorderRules(&defaultContext, sbml);
+}
+
+DLL_EXPORT int nom_reorderDocumentRules (NOMContext *ctx, SBMLDocument *doc)
+{
+	try
+	{
 		ConversionProperties props;
 		props.addOption("sortRules", true);
 
 		SBMLRuleConverter converter;
 		converter.setDocument(doc);
 		converter.setProperties(&props);
-		int ret = converter.convert();
-		char * string = doc->toSBML();
-		*sbml = string; 
-		delete doc;
-		return ret;
+		return converter.convert();
 	}
 	catch (...)
 	{
-		errorCode = 25;
+		ctx->errorCode = 25;
 		return -1;
 	}
 }
 
+DLL_EXPORT int reorderDocumentRules (SBMLDocument *doc)
+{
+	return nom_reorderDocumentRules(&defaultContext, doc);
+}
+
 void changePow (ASTNode* node)
 {
 	unsigned int c;
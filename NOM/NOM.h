@@ -81,6 +81,44 @@ extern "C" {
 	DLL_EXPORT int loadSBML(const char* sbmlStr);
 
 
+	/** @brief Parse SBML into a document without loading it into the NOM
+	*
+	* @param[in] sbmlStr sbmlStr is a char pointer to the SBML model
+	* @return the parsed document, which is owned by the caller
+	*/
+	DLL_EXPORT SBMLDocument* readSBMLDocument(const char* sbmlStr);
+
+
+	/** @brief Parse SBML held in memory into a document without loading it into the NOM
+	*
+	* @param[in] sbml the SBML model, which need not be NUL terminated
+	* @param[in] length the number of bytes of the model
+	* @return the parsed document, which is owned by the caller
+	*/
+	DLL_EXPORT SBMLDocument* readSBMLDocumentFromMemory(const char* sbml, size_t length);
+
+
+	/** @brief Parse an SBML file into a document without loading it into the NOM
+	*
+	* The file is handed straight to the libSBML file reader, so it is never
+	* held in memory as a string and error line numbers match the file.
+	*
+	* @param[in] fileName the name of the SBML file
+	* @return the parsed document, which is owned by the caller
+	*/
+	DLL_EXPORT SBMLDocument* readSBMLDocumentFromFile(const char* fileName);
+
+
+	/** @brief Load an already parsed SBML document into the NOM. 
+	*
+	* The NOM takes ownership of the document and frees it when the next model is loaded.
+	*
+	* @param[in] oDoc the document to load
+	* @return -1 if there has been an error, otherwise returns 0
+	*/
+	DLL_EXPORT int loadSBMLDocument(SBMLDocument *oDoc);
+
+
 	/** @brief Returns number of errors in SBML model
 	*
 	* @return -1 if there has been an error, otherwise returns number of errors in SBML model
@@ -154,6 +192,38 @@ extern "C" {
 	DLL_EXPORT int validate(const char *sbmlStr);
 
 
+	/** @brief Validates an already parsed SBML document
+	*
+	* @param[in] oDoc is the document to validate
+	* @return -1 if the SBML document is invalid, else returns 0
+	*/
+	DLL_EXPORT int validateDocument(SBMLDocument *oDoc);
+
+
+	/** @brief Runs the full set of libSBML consistency checks on a parsed SBML document
+	*
+	* The failures are added to the error log of the document.
+	*
+	* @param[in] oDoc is the document to check
+	* @return -1 if the SBML document is inconsistent, else returns 0
+	*/
+	DLL_EXPORT int checkDocumentConsistency(SBMLDocument *oDoc);
+
+
+	/** @brief Runs the libSBML consistency checks on a parsed SBML document, one category per thread
+	*
+	* Each check category runs on its own copy of the document. The failures are merged into the
+	* error log of the document in the same order, and with the same results, as checkDocumentConsistency.
+	* Documents that use SBML packages are checked serially, since the package validators cannot be
+	* split by category.
+	*
+	* @param[in] oDoc is the document to check
+	* @param[in] numThreads is the number of threads to use, 0 to use one per processor
+	* @return -1 if the SBML document is inconsistent, else returns 0
+	*/
+	DLL_EXPORT int checkDocumentConsistencyParallel(SBMLDocument *oDoc, int numThreads);
+
+
 	/** @brief Return the model name in the current model
 	*
 	* @param[out] name of the model
@@ -486,6 +556,14 @@ extern "C" {
 	DLL_EXPORT int getParamPromotedSBML (const char *inSBML, char **outSBML);
 
 
+	/** @brief Promotes the local parameters of a parsed document to global status in place
+	*
+	* @param[in] oDoc is the document to modify
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int promoteLocalParameters (SBMLDocument *oDoc);
+
+
 	/** @brief Fills in any missing modifiers to the SBML file
 	*
 	* @param[in] SBML is the input sbml string
@@ -518,6 +596,13 @@ extern "C" {
 	*/
 	DLL_EXPORT int reorderRules(char **sbml);
 
+	/** @brief reorders rules of a parsed document in place
+	*
+	* @param[in] oDoc is the document to be modified by rule reordering
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int reorderDocumentRules(SBMLDocument *oDoc);
+
 	/** @brief converts input SBML to another level and version
 	*
 	* @param[in] inputModel is the input SBML to be converted to another version
@@ -528,6 +613,561 @@ extern "C" {
 	*/
 	DLL_EXPORT int convertSBML(const char *inputModel, char **outputModel, int nLevel, int nVersion);
 
+
+	/** @brief A NOM context, holding one loaded model and the error state of the calls made on it
+	*
+	* Every function of the NOM has a nom_ counterpart that takes a context as
+	* its first argument and otherwise behaves the same. Different contexts can
+	* be used from different threads at the same time, one context must only be
+	* used by one thread at a time. The functions without a context work on a
+	* process wide default context.
+	*/
+	typedef struct NOMContext NOMContext;
+
+	/** @brief Creates an empty NOM context
+	*
+	* @return the context, free it with nom_context_free
+	*/
+	DLL_EXPORT NOMContext* nom_context_create();
+
+	/** @brief Frees a NOM context and the model loaded into it
+	*
+	* @param[in] ctx the context to free, the default context is never freed
+	*/
+	DLL_EXPORT void nom_context_free(NOMContext *ctx);
+
+	/** @brief Returns the context used by the functions without a context argument
+	*/
+	DLL_EXPORT NOMContext* nom_default_context();
+
+	/** @brief converts input SBML to another level and version
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] inputModel is the input SBML to be converted to another version
+	* @param[out] outputModel is the pointer to the output SBML 
+	* @param[in] nLevel is the level of output SBML
+	* @param[in] nVersion is the version of output SBML
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_convertSBML(NOMContext *ctx, const char *inputModel, char **outputModel, int nLevel, int nVersion);
+
+	/** @brief Load SBML into the NOM. 
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] sbmlStr sbmlStr is a char pointer to the SBML model
+	* @return -1 if there has been an error, otherwise returns 0
+	*/
+	DLL_EXPORT int nom_loadSBML(NOMContext *ctx, const char* sbmlStr);
+
+	/** @brief Load an already parsed SBML document into the NOM. 
+	*
+	* The NOM takes ownership of the document and frees it when the next model is loaded.
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] oDoc the document to load
+	* @return -1 if there has been an error, otherwise returns 0
+	*/
+	DLL_EXPORT int nom_loadSBMLDocument(NOMContext *ctx, SBMLDocument *oDoc);
+
+	/** @brief Returns the error message given the last error code generated
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @return char* to the error message
+	*/
+	DLL_EXPORT const char *nom_getError (NOMContext *ctx);
+
+	/** @brief Returns 0 (false) in the argument list if the species given by sId does not have
+	*  an amount associated with it, otherwise returns 1 (true)
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] sId is the Id of the species
+	* @param[out] isInitialAmount is 0 if false, 1 if true
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_hasInitialAmount (NOMContext *ctx, char *sId, bool *isInitialAmount);
+
+	/** @brief Returns 0 (false) in the argument list if the species given by sId does not have
+	*  a concentration associated with it, otherwise returns 1 (true)
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] cId is the Id of the species
+	* @param[out] hasInitial is 0 if false, 1 if true
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_hasInitialConcentration (NOMContext *ctx, char *cId, int *hasInitial);
+
+	/** @brief Get the value for a given symbol in the SBML
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] sId This is the name of the symbol to request the value for
+	* @param[out] value The value of the symbol is returned in this argument
+	* @return -1 if there has been an error, otherwise returns 0
+	*/
+	DLL_EXPORT int nom_getValue (NOMContext *ctx, char *sId, double *value);
+
+	/** @brief Set the value for a given symbol in the SBML
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] sId is the name of the symbol to set the value to
+	* @param[in] dValue The value which wish to use
+	* @return -1 if there has been an error, otherwise returns 0
+	*/
+	DLL_EXPORT int nom_setValue (NOMContext *ctx, char *sId, double dValue);
+
+	/** @brief Retrusn 0 (false) the supplied SBML string is invalid, else returns 1 (true)
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] sbmlStr is the SBML string to validate
+	* @return -1 if there has been an error, otherwise returns 0
+	*/
+	DLL_EXPORT int nom_validate(NOMContext *ctx, const char *sbml);
+
+	/** @brief Validates an already parsed SBML document
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] oDoc is the document to validate
+	* @return -1 if the SBML document is invalid, else returns 0
+	*/
+	DLL_EXPORT int nom_validateDocument(NOMContext *ctx, SBMLDocument *oDoc);
+
+	/** @brief Runs the full set of libSBML consistency checks on a parsed SBML document
+	*
+	* The failures are added to the error log of the document.
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] oDoc is the document to check
+	* @return -1 if the SBML document is inconsistent, else returns 0
+	*/
+	DLL_EXPORT int nom_checkDocumentConsistency(NOMContext *ctx, SBMLDocument *oDoc);
+
+	/** @brief Runs the libSBML consistency checks on a parsed SBML document, one category per thread
+	*
+	* Each check category runs on its own copy of the document. The failures are merged into the
+	* error log of the document in the same order, and with the same results, as checkDocumentConsistency.
+	* Documents that use SBML packages are checked serially, since the package validators cannot be
+	* split by category.
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] oDoc is the document to check
+	* @param[in] numThreads is the number of threads to use, 0 to use one per processor
+	* @return -1 if the SBML document is inconsistent, else returns 0
+	*/
+	DLL_EXPORT int nom_checkDocumentConsistencyParallel(NOMContext *ctx, SBMLDocument *oDoc, int numThreads);
+
+	/** @brief Returns number of errors in SBML model
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @return -1 if there has been an error, otherwise returns number of errors in SBML model
+	*/
+	DLL_EXPORT int nom_getNumErrors(NOMContext *ctx);
+
+	/** @brief Returns details on the index^th error
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] index The index^th error in the list
+	* @param[out] line The line number in the SBML file that corresponds to the error
+	* @param[out] column The column number in the SBML file that corresponds to the error
+	* @param[out] errorId The SBML errorId (see libSBML for details);
+	* @param[out] errorType The error type includes "Advisory", "Warning", "Fatal", "Error", and "Warning"
+	* @param[out] errorMsg The error message associated with the error
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getNthError (NOMContext *ctx, int index, int *line, int *column, int *errorId, char **errorType, char **errorMsg);
+
+	/** @brief Validates the given SBML model
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @return -1 if the SBML model is invalid, else returns 0
+	*/
+	DLL_EXPORT int nom_validateSBML(NOMContext *ctx, const char *cSBML);
+
+	/** @brief Return the model name in the current model
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[out] name of the model
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getModelName (NOMContext *ctx, char **name);
+
+	/** @brief Return the model Id for the current model
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[out] sId the current model
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getModelId (NOMContext *ctx, char **Id);
+
+	/** @brief Set the model Id for the current model
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[out] cId the Id to set in the current model
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_setModelId (NOMContext *ctx, char *cId);
+
+	/** @brief Return the number of function definitions in the current model
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @return -1 if there has been an error, otherwise returns # of function definitions
+	*/
+	DLL_EXPORT int nom_getNumFunctionDefinitions(NOMContext *ctx);
+
+	/** @brief Return the number of compartment in the current model
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @return -1 if there has been an error, otherwise returns # of compartments
+	*/
+	DLL_EXPORT int nom_getNumCompartments(NOMContext *ctx);
+
+	/** @brief Return the number of reactions in the current model
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @return -1 if there has been an error, otherwise returns # of reactions
+	*/
+	DLL_EXPORT int nom_getNumReactions(NOMContext *ctx);
+
+	/** @brief Return the number of floating species in the current model
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @return -1 if there has been an error, otherwise returns # of floating species
+	*/
+	DLL_EXPORT int nom_getNumFloatingSpecies(NOMContext *ctx);
+
+	/** @brief Return the number of boundary species in the current model
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @return -1 if there has been an error, otherwise returns # of boundary species
+	*/
+	DLL_EXPORT int nom_getNumBoundarySpecies(NOMContext *ctx);
+
+	/** @brief Return the number of global parameters in the current model
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @return -1 if there has been an error, otherwise returns # of global parameters
+	*/
+	DLL_EXPORT int nom_getNumGlobalParameters(NOMContext *ctx);
+
+	/** @brief Collects information on the index^th function definition
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] index is the index^th function definition to consider
+	* @param[out] fnId is the Id for this function definition
+	* @param[out] numArgs is the number of arguments for this function definition
+	* @param[out] argList is the list of arguments (names) to the function definition
+	* @param[out] body is the main body of the function definition in infix notation
+	* @return -1 if there has been an error, otherwise returns 0
+	*/
+	DLL_EXPORT int nom_getNthFunctionDefinition (NOMContext *ctx, int index, char** fnId, int *numArgs, char*** argList, char** body);
+
+	/** @brief Returns the nIndex^th compartment name
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] nIndex is the nIndex^th compartment name
+	* @param[out] name is the name of the nIndex^th compartment
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getNthCompartmentName (NOMContext *ctx, int nIndex, char **name);
+
+	/** @brief Returns the nIndex^th compartment Id
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] nIndex is the nIndex^th compartment Id
+	* @param[out] sId is the Id of the nIndex^th floating species
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getNthCompartmentId (NOMContext *ctx, int nIndex, char **Id);
+
+	/** @brief Returns a list of the Ids of the floating species
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[out] IdList is a array of char* containing the names of the floating species
+	* @param[out] numFloat is the number of boundary species in the list
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getListOfFloatingSpeciesIds (NOMContext *ctx, char*** IdList, int *numFloat);
+
+	/** @brief Returns the nIndex^th floating species name
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] nIndex is the nIndex^th floating species name
+	* @param[out] name is the name of the nIndex^th floating species
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getNthFloatingSpeciesName (NOMContext *ctx, int nIndex, char **name);
+
+	/** @brief Returns the nIndex^th floating species Id
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] nIndex is the nIndex^th floating species Id
+	* @param[out] sId is the Id of the nIndex^th floating species
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getNthFloatingSpeciesId (NOMContext *ctx, int nIndex, char** name);
+
+	/** @brief Returns a list of the Ids of the boundary species
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[out] IdList is a array of char* containing the names of the boundary species
+	* @param[out] numBoundary is the number of boundary species in the list
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getListOfBoundarySpeciesIds (NOMContext *ctx, char*** IdList, int *numBoundary);
+
+	/** @brief Returns the nIndex^th boundary species name
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] nIndex is the nIndex^th boundary spedcies name
+	* @param[out] name is the name of the nIndex^th boundary species
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getNthBoundarySpeciesName (NOMContext *ctx, int nIndex, char **name);
+
+	/** @brief Returns the nIndex^th boundary species Id
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] nIndex is the nIndex^th boundary spedcies Id
+	* @param[out] sId is the Id of the nIndex^th boundary species
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getNthBoundarySpeciesId (NOMContext *ctx, int nIndex, char **name);
+
+	/** @brief Returns the compartment Id associated with a particular species Id
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] cId species Id
+	* @param[out] sId is the Id of the accociated species
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getCompartmentIdBySpeciesId (NOMContext *ctx, char *cId, char **compId);
+
+	/** @brief Returns if reaction is reversible
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] arg is the reaction number index
+	* @param[out] isReversible is 1 if the reaction is reversible and 0 if not.
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_isReactionReversible(NOMContext *ctx, int arg, int *isReversible);
+
+	/** @brief Returns the nIndex^th reaction name
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] nIndex is the nIndex^th reaction
+	* @param[out] name is the name of the nIndex^th reaction
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getNthReactionName (NOMContext *ctx, int nIndex, char **name);
+
+	/** @brief Returns the nIndex^th reaction Id
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] nIndex is the nIndex^th reaction Id
+	* @param[out] sId is the Id that is returned to the caller
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getNthReactionId (NOMContext *ctx, int nIndex, char **Id);
+
+	/** @brief Return the number of reactants for the arg^th reaction
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getNumReactants (NOMContext *ctx, int arg);
+
+	/** @brief Return the number of reactants for the arg^th reaction
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getNumProducts (NOMContext *ctx, int arg);
+
+	/** @brief Return the name of the arg2^th reactant from the arg1^th reaction
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] arg1 is the ith reaction 
+	* @param[in] arg2 is the ith reactant
+	* @param[out] name is the reactant name that is returned
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getNthReactantName (NOMContext *ctx, int arg1, int arg2, char **name);
+
+	/** @brief Return the name of the arg2^th reactant from the arg1^th reaction
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] arg1 is the ith reaction 
+	* @param[in] arg2 is the ith product
+	* @param[out] name is the product name that is returned
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getNthProductName (NOMContext *ctx, int arg1, int arg2, char **name);
+
+	/** @brief Return the kinetic law of the index^th reaction
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] index is the ith reaction  to obtain the kinetic law from
+	* @param[out] kineticLaw is the string returned by the call
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getKineticLaw (NOMContext *ctx, int index, char **kineticLaw);
+
+	/** @brief Returns the arg2^th reactant stoichiometry from the arg1^th reaction
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] arg1 is the ith reaction 
+	* @param[in] arg2 is the ith reactant
+	* @return -1 if there has been an error or the value of the stoichiometric amount
+	*/
+	DLL_EXPORT double nom_getNthReactantStoichiometry (NOMContext *ctx, int arg1, int arg2);
+
+	/** @brief Returns the arg2^th product stoichiometry from the arg1^th reaction
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] arg1 is the ith reaction 
+	* @param[in] arg2 is the ith product
+	* @return -1 if there has been an error or the value of the stoichiometric amount
+	*/
+	DLL_EXPORT double nom_getNthProductStoichiometry (NOMContext *ctx, int arg1, int arg2);
+
+	/** @brief Any local parameters in an SBML model are promoted to global status by this call. 
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] in SBML is the input sbml string
+	* @param[out] ou tSBML is output sbml string with local parameters promoted to global parameters
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getParamPromotedSBML (NOMContext *ctx, const char *inSBML, char **outSBML);
+
+	/** @brief Promotes the local parameters of a parsed document to global status in place
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] oDoc is the document to modify
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_promoteLocalParameters (NOMContext *ctx, SBMLDocument *oSBMLDoc);
+
+	/** @brief Returns the number of local parameters
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] reactionIndex is the ith reaction 
+	* @return -1 if there has been an error or the number of local parameters
+	*/
+	DLL_EXPORT int nom_getNumLocalParameters (NOMContext *ctx, int reactionIndex);
+
+	/** @brief Returns the name of nth local parameter is a given reaction
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] reactionIndex is the ith reaction 
+	* @param[in] parameterIndex is the ith product
+	* @param[out] sId Pointer to the name of the local parameter
+	* @return -1 if there has been an error 
+	*/
+	DLL_EXPORT int nom_getNthLocalParameterName (NOMContext *ctx, int reactionIndex, int parameterIndex, char **sId);
+
+	/** @brief Returns the Id of nth local parameter is a given reaction
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] reactionIndex is the ith reaction 
+	* @param[in] parameterIndex is the ith product
+	* @param[out] sId Pointer to the Id of the local parameter
+	* @return -1 if there has been an error 
+	*/
+	DLL_EXPORT int nom_getNthLocalParameterId (NOMContext *ctx, int reactionIndex, int parameterIndex, char **sId);
+
+	/** @brief Returns the value of the specificed local parameter
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] reactionIndex is the ith reaction 
+	* @param[in] parameterIndex is the ith product
+	* @param[out] value Pointer to the value of the local parameter
+	* @return -1 if there has been an error 
+	*/
+	DLL_EXPORT int nom_getNthLocalParameterValue (NOMContext *ctx, int reactionIndex, int parameterIndex, double *value);
+
+	/** @brief Returns the nIndex^th global parameter name
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] nIndex is the nIndex^th global parameter name
+	* @param[out] name is the name of the nIndex^th global parameter name
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getNthGlobalParameterName (NOMContext *ctx, int nIndex, char **name);
+
+	/** @brief Returns the nIndex^th global parameter Id
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] nIndex is the nIndex^th global parameter Id
+	* @param[out] sId is the Id of the nIndex^th global parameter Id
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_getNthGlobalParameterId (NOMContext *ctx, int nIndex, char **Id);
+
+	/** @brief Returns the number of rules in the SBML model
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @return -1 if there has been an error or the number of rules
+	*/
+	DLL_EXPORT int nom_getNumRules(NOMContext *ctx);
+
+	/** @brief Returns the nIndex^th rule from the current model
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] nIndex is the nIndex^th rule
+	* @param[out] rule Pointer to a char* that will return the rule itself
+	* @param[out] ruleType Pointer to a char* that will return the type of the rule (i.e. algebraic, assignment, etc)
+	* @return -1 if there has been an error or the number of rules
+	*/
+	DLL_EXPORT int nom_getNthRule (NOMContext *ctx, int nIndex, char **rule, int *ruleType);
+
+	/** @brief Returns the number of events in the SBML model
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @return -1 if there has been an error or the number of events
+	*/
+	DLL_EXPORT int nom_getNumEvents(NOMContext *ctx);
+
+	/** @brief Converts a MathML string into infix notation
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] MathML is the input string
+	* @param[out] infix notation is the output string
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_convertMathMLToString (NOMContext *ctx, const char *mathMLStr, char **infix);
+
+	/** @brief Converts an infix string into MathML Notation
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] infix is the input string
+	* @param[out] MathML notation is the output string
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_convertStringToMathML (NOMContext *ctx, const char* infixStr, char **mathMLStr);
+
+	/** @brief Fills in any missing modifiers to the SBML file
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] SBML is the input sbml string
+	* @param[out] SBML is output sbml string with modifiers added
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_addMissingModifiers (NOMContext *ctx, const char *inSBML, char **outSBML);
+
+	/** @brief reorders rules in SBML
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] sbml is the input sbml string to be modified by rule reordering
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_reorderRules (NOMContext *ctx, char **sbml);
+
+	/** @brief reorders rules of a parsed document in place
+	*
+	* @param[in] ctx is the NOM context to work in
+	* @param[in] oDoc is the document to be modified by rule reordering
+	* @return -1 if there has been an error
+	*/
+	DLL_EXPORT int nom_reorderDocumentRules (NOMContext *ctx, SBMLDocument *doc);
+
 }
 
 #endif
@@ -0,0 +1,328 @@
+/* Filename    : batchInputs.cpp
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the University of Washington nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "batchInputs.h"
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+// the type test macros are missing from the Windows headers
+#if defined(WIN32) && !defined(S_ISREG)
+#define S_ISREG(mode) (((mode) & S_IFMT) == S_IFREG)
+#define S_ISDIR(mode) (((mode) & S_IFMT) == S_IFDIR)
+#endif
+
+#ifdef WIN32
+#include <windows.h>
+#include <direct.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+// extensions of the files taken from a directory, before any compression extension
+static const char* SBML_EXTENSIONS[] = { ".xml", ".sbml" };
+static const char* COMPRESSION_EXTENSIONS[] = { ".gz", ".bz2", ".zip" };
+
+static bool endsWith(const string& name, const string& suffix)
+{
+	return name.length() >= suffix.length()
+		&& name.compare(name.length() - suffix.length(), suffix.length(), suffix) == 0;
+}
+
+bool isSBMLFileName(const string& fileName)
+{
+	string name = fileName;
+	transform(name.begin(), name.end(), name.begin(), ::tolower);
+	for (size_t i = 0; i < sizeof(COMPRESSION_EXTENSIONS) / sizeof(COMPRESSION_EXTENSIONS[0]); i++)
+	{
+		if (endsWith(name, COMPRESSION_EXTENSIONS[i]))
+		{
+			name.erase(name.length() - strlen(COMPRESSION_EXTENSIONS[i]));
+			break;
+		}
+	}
+	for (size_t i = 0; i < sizeof(SBML_EXTENSIONS) / sizeof(SBML_EXTENSIONS[0]); i++)
+	{
+		if (endsWith(name, SBML_EXTENSIONS[i]))
+			return true;
+	}
+	return false;
+}
+
+// adds a file with its size, returns false if it is no regular file
+static bool addInput(const string& fileName, vector<TBatchInput>& inputs)
+{
+	struct stat info;
+	if (stat(fileName.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+		return false;
+	TBatchInput input;
+	input.fileName = fileName;
+	input.size = (unsigned long long) info.st_size;
+	inputs.push_back(input);
+	return true;
+}
+
+static bool listDirectory(const string& directory, vector<TBatchInput>& inputs)
+{
+	vector<string> names;
+#ifdef WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE handle = FindFirstFileA((directory + "\\*").c_str(), &data);
+	if (handle == INVALID_HANDLE_VALUE) return false;
+	do
+	{
+		if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+		names.push_back(data.cFileName);
+	} while (FindNextFileA(handle, &data));
+	FindClose(handle);
+#else
+	DIR* dir = opendir(directory.c_str());
+	if (dir == NULL) return false;
+	struct dirent* entry;
+	while ((entry = readdir(dir)) != NULL)
+	{
+		names.push_back(entry->d_name);
+	}
+	closedir(dir);
+#endif
+
+	// the directory order differs between file systems, sort it so equally
+	// large files are always translated in the same order
+	sort(names.begin(), names.end());
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		if (isSBMLFileName(names[i]))
+			addInput(directory + "/" + names[i], inputs);
+	}
+	return true;
+}
+
+static bool readManifest(const string& manifest, vector<TBatchInput>& inputs, string& error)
+{
+	ifstream in(manifest.c_str());
+	if (!in.is_open())
+	{
+		error = "cannot be opened";
+		return false;
+	}
+
+	string base;
+	size_t slash = manifest.find_last_of("/\\");
+	if (slash != string::npos)
+		base = manifest.substr(0, slash + 1);
+
+	string line;
+	for (int lineNumber = 1; getline(in, line); lineNumber++)
+	{
+		size_t begin = line.find_first_not_of(" \t\r");
+		if (begin == string::npos || line[begin] == '#')
+			continue;
+		string fileName = line.substr(begin, line.find_last_not_of(" \t\r") - begin + 1);
+
+		bool bAbsolute = fileName[0] == '/' || fileName[0] == '\\' || (fileName.length() > 1 && fileName[1] == ':');
+		if (!bAbsolute)
+			fileName = base + fileName;
+		if (!addInput(fileName, inputs))
+		{
+			stringstream message;
+			message << "line " << lineNumber << ": '" << fileName << "' is no readable file";
+			error = message.str();
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool isLarger(const TBatchInput& a, const TBatchInput& b)
+{
+	return a.size > b.size;
+}
+
+bool listBatchInputs(const string& source, vector<TBatchInput>& inputs, string& error)
+{
+	inputs.clear();
+	bool bRead = isDirectory(source) ? listDirectory(source, inputs) : readManifest(source, inputs, error);
+	if (!bRead)
+	{
+		if (error.empty())
+			error = "cannot be read";
+		return false;
+	}
+
+	// the largest models go first so no worker is left with one at the end
+	stable_sort(inputs.begin(), inputs.end(), isLarger);
+	return true;
+}
+
+bool isDirectory(const string& name)
+{
+	struct stat info;
+	return stat(name.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+bool makeDirectory(const string& name)
+{
+#ifdef WIN32
+	_mkdir(name.c_str());
+#else
+	mkdir(name.c_str(), 0777);
+#endif
+	return isDirectory(name);
+}
+
+MappedFile::MappedFile()
+  : _data(NULL)
+  , _size(0)
+  , _device(0)
+  , _inode(0)
+  , _fileSize(0)
+  , _modified(0)
+  , _buffer()
+#ifdef WIN32
+  , _mapping(NULL)
+#endif
+{
+}
+
+MappedFile* MappedFile::open(const string& fileName, string& error)
+{
+	MappedFile* file = new MappedFile();
+#ifdef WIN32
+	struct stat info;
+	if (stat(fileName.c_str(), &info) == 0)
+		file->remember(info);
+	HANDLE handle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (handle != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER size;
+		if (GetFileSizeEx(handle, &size) && size.QuadPart > 0)
+		{
+			file->_mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (file->_mapping != NULL)
+			{
+				file->_data = (const char*) MapViewOfFile(file->_mapping, FILE_MAP_READ, 0, 0, 0);
+				file->_size = (size_t) size.QuadPart;
+				if (file->_data == NULL)
+				{
+					CloseHandle(file->_mapping);
+					file->_mapping = NULL;
+				}
+			}
+		}
+		CloseHandle(handle);
+	}
+#else
+	int handle = ::open(fileName.c_str(), O_RDONLY);
+	if (handle >= 0)
+	{
+		struct stat info;
+		if (fstat(handle, &info) == 0 && info.st_size > 0)
+		{
+			file->remember(info);
+			void* data = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, handle, 0);
+			if (data != MAP_FAILED)
+			{
+				madvise(data, (size_t) info.st_size, MADV_SEQUENTIAL);
+				file->_data = (const char*) data;
+				file->_size = (size_t) info.st_size;
+			}
+		}
+		close(handle);
+	}
+#endif
+	if (file->_data != NULL)
+		return file;
+
+	// empty files and files that cannot be mapped, e.g. pipes, are read
+	struct stat current;
+	if (stat(fileName.c_str(), &current) == 0)
+		file->remember(current);
+	ifstream in(fileName.c_str(), ios::in | ios::binary);
+	if (!in.is_open())
+	{
+		delete file;
+		error = "cannot be read";
+		return NULL;
+	}
+	file->_buffer.assign((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+	file->_data = file->_buffer.data();
+	file->_size = file->_buffer.size();
+	return file;
+}
+
+MappedFile::~MappedFile()
+{
+	if (_data == NULL || _data == _buffer.data())
+		return;
+#ifdef WIN32
+	UnmapViewOfFile(_data);
+	CloseHandle(_mapping);
+#else
+	munmap((void*) _data, _size);
+#endif
+}
+
+void MappedFile::remember(const struct stat& info)
+{
+	_device = (unsigned long long) info.st_dev;
+	_inode = (unsigned long long) info.st_ino;
+	_fileSize = (unsigned long long) info.st_size;
+	_modified = (unsigned long long) info.st_mtime;
+}
+
+bool MappedFile::isCurrent(const string& fileName) const
+{
+	struct stat info;
+	return stat(fileName.c_str(), &info) == 0
+		&& (unsigned long long) info.st_dev == _device
+		&& (unsigned long long) info.st_ino == _inode
+		&& (unsigned long long) info.st_size == _fileSize
+		&& (unsigned long long) info.st_mtime == _modified;
+}
+
+void MappedFile::prefetch() const
+{
+	if (_data == _buffer.data())
+		return;
+#ifndef WIN32
+	madvise((void*) _data, _size, MADV_WILLNEED);
+#endif
+	// touching one byte per page faults the whole file in
+	volatile char sum = 0;
+	for (size_t offset = 0; offset < _size; offset += 4096)
+	{
+		sum += _data[offset];
+	}
+}
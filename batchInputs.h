@@ -0,0 +1,121 @@
+/**
+* @file batchInputs.h
+* @brief Collects the SBML files of a batch translation
+*
+*/
+
+/* 
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the University of Washington nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
+
+#ifndef BATCH_INPUTS_H
+#define BATCH_INPUTS_H
+
+#include <string>
+#include <vector>
+
+/** @brief An SBML file to be translated as part of a batch */
+typedef struct {
+	std::string fileName;
+	unsigned long long size; /**< Size of the file in bytes */
+} TBatchInput;
+
+/** @brief Lists the SBML files of a batch, largest first
+*
+* The source is either a directory, whose .xml and .sbml files are taken
+* (also when compressed with gzip, bzip2 or zip), or a manifest: a text file
+* naming one SBML file per line. Empty lines and lines starting with # are
+* skipped, relative names are taken relative to the manifest. Files of equal
+* size keep the order they were listed in.
+*
+* @param[in] source The directory or manifest
+* @param[out] inputs The SBML files
+* @param[out] error Why the source cannot be read
+* @return false if the source cannot be read
+*/
+bool listBatchInputs(const std::string& source, std::vector<TBatchInput>& inputs, std::string& error);
+
+/** @brief Returns whether a file name ends in .xml or .sbml, possibly followed by .gz, .bz2 or .zip */
+bool isSBMLFileName(const std::string& fileName);
+
+/** @brief An input file mapped into memory
+*
+* Where the file cannot be mapped it is read into memory instead, so the
+* content is always available through data() and size().
+*/
+class MappedFile
+{
+public:
+	/** @brief Maps a file
+	*
+	* @param[in] fileName The file to map
+	* @param[out] error Why the file cannot be read
+	* @return the mapped file, or NULL if it cannot be read
+	*/
+	static MappedFile* open(const std::string& fileName, std::string& error);
+
+	~MappedFile();
+
+	/** @brief Reads every page of the file, so later accesses do not wait for the disk */
+	void prefetch() const;
+
+	/** @brief Returns whether the file is still the one that was mapped
+	*
+	* A file that was replaced, or written to, since it was mapped may no
+	* longer hold the content of the mapping.
+	*
+	* @param[in] fileName The file that was mapped
+	*/
+	bool isCurrent(const std::string& fileName) const;
+
+	const char* data() const { return _data; }
+	size_t size() const { return _size; }
+
+private:
+	MappedFile();
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	void remember(const struct stat& info);
+
+	const char* _data;
+	size_t _size;
+	unsigned long long _device, _inode, _fileSize, _modified; // what the file was when it was mapped
+	std::string _buffer; // the content when it could not be mapped
+#ifdef WIN32
+	void* _mapping;
+#endif
+};
+
+/** @brief Returns whether the given name is a directory */
+bool isDirectory(const std::string& name);
+
+/** @brief Creates a directory unless it exists already
+*
+* @return false if the directory does not exist afterwards
+*/
+bool makeDirectory(const std::string& name);
+
+#endif
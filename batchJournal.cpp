@@ -0,0 +1,159 @@
+/* Filename    : batchJournal.cpp
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the University of Washington nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "batchJournal.h"
+#include <fstream>
+
+using namespace std;
+
+// the records, one per line: <kind> <hash> <input file>
+static const char* RECORD_STARTED = "started";
+static const char* RECORD_COMPLETED = "completed";
+static const char* RECORD_TRANSLATED = "translated";
+static const char* RECORD_FAILED = "failed";
+static const char* RECORD_QUARANTINED = "quarantined";
+
+BatchJournal::BatchJournal(FILE* file)
+  : _file(file)
+  , _lock()
+  , _entries()
+{
+}
+
+BatchJournal* BatchJournal::open(const string& fileName, bool bResume, string& error)
+{
+	map<string, TEntry> entries;
+	if (bResume)
+	{
+		ifstream in(fileName.c_str());
+		string line;
+		while (getline(in, line))
+		{
+			// the last line may have been cut off by a crash
+			size_t hashStart = line.find(' ');
+			size_t inputStart = hashStart == string::npos ? string::npos : line.find(' ', hashStart + 1);
+			if (inputStart == string::npos)
+				continue;
+
+			string kind = line.substr(0, hashStart);
+			if (kind != RECORD_STARTED && kind != RECORD_COMPLETED && kind != RECORD_TRANSLATED
+				&& kind != RECORD_FAILED && kind != RECORD_QUARANTINED)
+				continue;
+			string hash = line.substr(hashStart + 1, inputStart - hashStart - 1);
+			TEntry& entry = entries[line.substr(inputStart + 1)];
+			if (entry.hash != hash)
+			{
+				// a changed file starts over
+				entry.hash = hash;
+				entry.state = JOURNAL_NONE;
+				entry.crashes = 0;
+				entry.bRunning = false;
+			}
+
+			if (kind == RECORD_STARTED)
+			{
+				// started again without completing, the run before died on it
+				if (entry.bRunning)
+					entry.crashes++;
+				entry.bRunning = true;
+			}
+			else
+			{
+				// a translation that returned proves the crashes were not its doing
+				entry.bRunning = false;
+				entry.crashes = 0;
+				if (kind == RECORD_TRANSLATED)
+					entry.state = JOURNAL_DONE;
+				else if (kind == RECORD_FAILED)
+					entry.state = JOURNAL_FAILED;
+				else if (kind == RECORD_QUARANTINED)
+					entry.state = JOURNAL_CRASHED;
+			}
+		}
+
+		// the last run died while these were being translated; the files
+		// translated alongside the one to blame get a second chance, a file
+		// two runs in a row died on is quarantined
+		for (map<string, TEntry>::iterator it = entries.begin(); it != entries.end(); ++it)
+		{
+			if (it->second.bRunning)
+				it->second.crashes++;
+			if (it->second.crashes >= 2)
+				it->second.state = JOURNAL_CRASHED;
+		}
+	}
+
+	FILE* file = fopen(fileName.c_str(), bResume ? "a" : "w");
+	if (file == NULL)
+	{
+		error = "cannot be written";
+		return NULL;
+	}
+	BatchJournal* journal = new BatchJournal(file);
+	journal->_entries.swap(entries);
+	return journal;
+}
+
+BatchJournal::~BatchJournal()
+{
+	fclose(_file);
+}
+
+BatchJournal::TState BatchJournal::state(const string& input, const string& hash) const
+{
+	map<string, TEntry>::const_iterator it = _entries.find(input);
+	if (it == _entries.end() || it->second.hash != hash)
+		return JOURNAL_NONE;
+	return it->second.state;
+}
+
+void BatchJournal::started(const string& input, const string& hash)
+{
+	append(RECORD_STARTED, hash, input);
+}
+
+void BatchJournal::completed(const string& input, const string& hash)
+{
+	append(RECORD_COMPLETED, hash, input);
+}
+
+void BatchJournal::finished(const string& input, const string& hash, bool bTranslated)
+{
+	append(bTranslated ? RECORD_TRANSLATED : RECORD_FAILED, hash, input);
+}
+
+void BatchJournal::quarantined(const string& input, const string& hash)
+{
+	append(RECORD_QUARANTINED, hash, input);
+}
+
+void BatchJournal::append(const char* kind, const string& hash, const string& input)
+{
+	lock_guard<mutex> lock(_lock);
+	fprintf(_file, "%s %s %s\n", kind, hash.c_str(), input.c_str());
+	// flushed to the system right away, so the record survives a crash of the process
+	fflush(_file);
+}
@@ -0,0 +1,104 @@
+/**
+* @file batchJournal.h
+* @brief Journal of the files a batch run has translated, for resuming it
+*
+*/
+
+/* 
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the University of Washington nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
+
+#ifndef BATCH_JOURNAL_H
+#define BATCH_JOURNAL_H
+
+#include <cstdio>
+#include <string>
+#include <map>
+#include <mutex>
+
+/** @brief Append only record of the progress of a batch run
+*
+* Every file is recorded with the hash of its content when its translation
+* starts, when its translation returns and again when its .m file has been
+* written. Each record is flushed right away, so after a crash the journal
+* tells which files were finished and which files were being translated
+* when the process died. As several files are translated at once, a file
+* is only taken for the cause of crashes once two runs died on it.
+*/
+class BatchJournal
+{
+public:
+	/** @brief What an earlier run did with a file */
+	enum TState
+	{
+		JOURNAL_NONE,    /**< Not translated yet, or changed since */
+		JOURNAL_DONE,    /**< Translated */
+		JOURNAL_FAILED,  /**< Could not be translated */
+		JOURNAL_CRASHED  /**< Quarantined, two runs died while translating it or it crashed a worker process */
+	};
+
+	/** @brief Opens a journal
+	*
+	* @param[in] fileName The journal file
+	* @param[in] bResume Whether to keep the records of earlier runs, otherwise the journal starts empty
+	* @param[out] error Why the journal cannot be used
+	* @return the journal, or NULL if it cannot be written
+	*/
+	static BatchJournal* open(const std::string& fileName, bool bResume, std::string& error);
+
+	~BatchJournal();
+
+	/** @brief Returns what earlier runs did with a file with the given content */
+	TState state(const std::string& input, const std::string& hash) const;
+
+	/** @brief Records that the translation of a file starts */
+	void started(const std::string& input, const std::string& hash);
+
+	/** @brief Records that the translation of a file returned, before its .m file is written */
+	void completed(const std::string& input, const std::string& hash);
+
+	/** @brief Records that the .m file of a file has been written */
+	void finished(const std::string& input, const std::string& hash, bool bTranslated);
+
+	/** @brief Records that a file is skipped from now on because it crashed runs or workers */
+	void quarantined(const std::string& input, const std::string& hash);
+
+private:
+	typedef struct {
+		std::string hash;
+		TState state;
+		int crashes; // runs that died while translating it
+		bool bRunning; // started and not completed yet
+	} TEntry;
+
+	BatchJournal(FILE* file);
+	void append(const char* kind, const std::string& hash, const std::string& input);
+
+	FILE* _file;
+	std::mutex _lock;
+	std::map<std::string, TEntry> _entries; // the last record of every file of earlier runs
+};
+
+#endif
@@ -52,7 +52,25 @@ public class"
 
 %ignore freeMatlabString;
 %ignore sbml2matlab;
+%ignore sbml2matlabWithOptions;
+%ignore sbml2matlabFile;
+%ignore sbml2matlabArchive;
+%ignore sbml2matlab_batch;
+%ignore sbml2matlab_submit;
+%ignore sbml2matlab_wait;
+%ignore sbml2matlab_stream;
 %ignore getNthSbmlError;
+%ignore getTranslationMemoryCacheStats;
+%ignore updateTranslationValues;
+%ignore translateInSession;
+
+/**
+ * Cancellation and progress reporting go through pointers shared with
+ * the translation, which only C and C++ callers can hand over.
+ */
+%ignore TranslationOptions::cancelFlag;
+%ignore TranslationOptions::progress;
+%ignore TranslationOptions::progressData;
 
 /**
  * Rename getMatlab as 'sbml2matlab', 
@@ -0,0 +1,112 @@
+/**
+* @file boundedQueue.h
+* @brief A blocking queue of limited depth connecting the stages of a batch run
+*
+*/
+
+/* 
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the University of Washington nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
+
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+/** @brief A first in, first out queue that blocks producers while it is full
+*
+* The depth limits how far a stage can run ahead of the next one, and with
+* it the memory held by the items in between.
+*/
+template <class T>
+class BoundedQueue
+{
+public:
+	/** @brief Creates an empty queue holding at most the given number of items */
+	explicit BoundedQueue(size_t capacity)
+	  : _items()
+	  , _capacity(capacity > 0 ? capacity : 1)
+	  , _bClosed(false)
+	{
+	}
+
+	/** @brief Appends an item, waiting while the queue is full
+	*
+	* @return false if the queue was closed, the item is dropped then
+	*/
+	bool push(const T& item)
+	{
+		std::unique_lock<std::mutex> lock(_lock);
+		while (_items.size() >= _capacity && !_bClosed)
+		{
+			_notFull.wait(lock);
+		}
+		if (_bClosed)
+			return false;
+		_items.push_back(item);
+		_notEmpty.notify_one();
+		return true;
+	}
+
+	/** @brief Takes the oldest item, waiting while the queue is empty
+	*
+	* @return false once the queue is closed and empty
+	*/
+	bool pop(T& item)
+	{
+		std::unique_lock<std::mutex> lock(_lock);
+		while (_items.empty() && !_bClosed)
+		{
+			_notEmpty.wait(lock);
+		}
+		if (_items.empty())
+			return false;
+		item = _items.front();
+		_items.pop_front();
+		_notFull.notify_one();
+		return true;
+	}
+
+	/** @brief Ends the queue, the items still queued can be taken */
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		_bClosed = true;
+		_notEmpty.notify_all();
+		_notFull.notify_all();
+	}
+
+private:
+	std::mutex _lock;
+	std::condition_variable _notEmpty;
+	std::condition_variable _notFull;
+	std::deque<T> _items;
+	size_t _capacity;
+	bool _bClosed;
+};
+
+#endif
@@ -0,0 +1,154 @@
+/* Filename    : contentHash.cpp
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the University of Washington nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "contentHash.h"
+#include <cstring>
+
+using namespace std;
+
+// SHA-256 round constants (FIPS 180-4)
+static const unsigned int sha256K[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline unsigned int rotr(unsigned int x, int n)
+{
+	return (x >> n) | (x << (32 - n));
+}
+
+TSha256::TSha256()
+  : _blockLength(0)
+  , _totalLength(0)
+{
+	_state[0] = 0x6a09e667; _state[1] = 0xbb67ae85; _state[2] = 0x3c6ef372; _state[3] = 0xa54ff53a;
+	_state[4] = 0x510e527f; _state[5] = 0x9b05688c; _state[6] = 0x1f83d9ab; _state[7] = 0x5be0cd19;
+	memset(_block, 0, sizeof(_block));
+}
+
+void TSha256::transform(const unsigned char* block)
+{
+	unsigned int w[64];
+	for (int i = 0; i < 16; i++)
+	{
+		w[i] = ((unsigned int) block[i*4] << 24) | ((unsigned int) block[i*4+1] << 16)
+			| ((unsigned int) block[i*4+2] << 8) | (unsigned int) block[i*4+3];
+	}
+	for (int i = 16; i < 64; i++)
+	{
+		unsigned int s0 = rotr(w[i-15], 7) ^ rotr(w[i-15], 18) ^ (w[i-15] >> 3);
+		unsigned int s1 = rotr(w[i-2], 17) ^ rotr(w[i-2], 19) ^ (w[i-2] >> 10);
+		w[i] = w[i-16] + s0 + w[i-7] + s1;
+	}
+
+	unsigned int a = _state[0], b = _state[1], c = _state[2], d = _state[3];
+	unsigned int e = _state[4], f = _state[5], g = _state[6], h = _state[7];
+	for (int i = 0; i < 64; i++)
+	{
+		unsigned int t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + sha256K[i] + w[i];
+		unsigned int t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+		h = g; g = f; f = e; e = d + t1;
+		d = c; c = b; b = a; a = t1 + t2;
+	}
+	_state[0] += a; _state[1] += b; _state[2] += c; _state[3] += d;
+	_state[4] += e; _state[5] += f; _state[6] += g; _state[7] += h;
+}
+
+void TSha256::update(const char* data, size_t length)
+{
+	const unsigned char* bytes = (const unsigned char*) data;
+	_totalLength += length;
+	while (length > 0)
+	{
+		size_t count = 64 - _blockLength;
+		if (count > length)
+			count = length;
+		memcpy(_block + _blockLength, bytes, count);
+		_blockLength += count;
+		bytes += count;
+		length -= count;
+		if (_blockLength == 64)
+		{
+			transform(_block);
+			_blockLength = 0;
+		}
+	}
+}
+
+string TSha256::hexDigest()
+{
+	unsigned long long bitLength = _totalLength * 8;
+
+	// pad with a one bit, zeros and the message length in bits
+	unsigned char padding = 0x80;
+	update((const char*) &padding, 1);
+	padding = 0;
+	while (_blockLength != 56)
+	{
+		update((const char*) &padding, 1);
+	}
+	unsigned char lengthBytes[8];
+	for (int i = 0; i < 8; i++)
+	{
+		lengthBytes[i] = (unsigned char) (bitLength >> (56 - 8*i));
+	}
+	update((const char*) lengthBytes, 8);
+
+	static const char* hexDigits = "0123456789abcdef";
+	string result;
+	for (int i = 0; i < 8; i++)
+	{
+		for (int j = 28; j >= 0; j -= 4)
+		{
+			result += hexDigits[(_state[i] >> j) & 0xf];
+		}
+	}
+	return result;
+}
+
+string sha256Hex(const string& data)
+{
+	TSha256 digest;
+	digest.update(data);
+	return digest.hexDigest();
+}
+
+unsigned long long fnv1a64(const char* data, size_t length, unsigned long long hash)
+{
+	const unsigned char* bytes = (const unsigned char*) data;
+	for (size_t i = 0; i < length; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
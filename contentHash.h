@@ -0,0 +1,76 @@
+/**
+* @file contentHash.h
+* @brief Content hashes used to key cached translations
+*
+*/
+
+/* 
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the University of Washington nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
+
+#ifndef CONTENT_HASH_H
+#define CONTENT_HASH_H
+
+#include <string>
+
+/** @brief Incremental SHA-256 digest
+*
+* Used wherever a translation has to be identified by its content, for
+* example the keys of the on-disk translation cache.
+*/
+class TSha256
+{
+public:
+	TSha256();
+
+	/** @brief Adds the given bytes to the digest */
+	void update(const char* data, size_t length);
+
+	/** @brief Adds the given string to the digest */
+	void update(const std::string& data) { update(data.data(), data.length()); }
+
+	/** @brief Finishes the digest and returns it as 64 lower case hex digits */
+	std::string hexDigest();
+
+private:
+	void transform(const unsigned char* block);
+
+	unsigned int		_state[8];
+	unsigned char		_block[64];
+	size_t				_blockLength;
+	unsigned long long	_totalLength;
+};
+
+/** @brief Returns the SHA-256 digest of the given string as hex digits */
+std::string sha256Hex(const std::string& data);
+
+/** @brief Returns the 64 bit FNV-1a hash of the given bytes
+*
+* Much cheaper than SHA-256 but not collision resistant, so users have to
+* compare the hashed content on a match.
+*/
+unsigned long long fnv1a64(const char* data, size_t length, unsigned long long hash = 14695981039346656037ULL);
+
+#endif
@@ -0,0 +1,240 @@
+/* Filename    : directoryWatcher.cpp
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the University of Washington nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "directoryWatcher.h"
+#include "batchInputs.h"
+#include <set>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+using namespace std;
+
+// how often a directory is scanned where it cannot be watched
+static const int SCAN_INTERVAL_MS = 250;
+
+DirectoryWatcher* DirectoryWatcher::open(const string& directory, string& error)
+{
+	if (!isDirectory(directory))
+	{
+		error = "not a directory";
+		return NULL;
+	}
+	DirectoryWatcher* watcher = new DirectoryWatcher(directory);
+#ifdef __linux__
+	// editors either write a file in place or rename a new one over it
+	watcher->_notify = inotify_init();
+	if (watcher->_notify >= 0
+		&& inotify_add_watch(watcher->_notify, directory.c_str(),
+			IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM | IN_DELETE_SELF | IN_MOVE_SELF) < 0)
+	{
+		close(watcher->_notify);
+		watcher->_notify = -1;
+	}
+#endif
+	if (watcher->_notify < 0 && !watcher->scan(watcher->_snapshot))
+	{
+		error = "cannot be read";
+		delete watcher;
+		return NULL;
+	}
+	return watcher;
+}
+
+DirectoryWatcher::DirectoryWatcher(const string& directory)
+	: _directory(directory)
+	, _notify(-1)
+	, _snapshot()
+{
+}
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+#ifdef __linux__
+	if (_notify >= 0)
+		close(_notify);
+#endif
+}
+
+bool DirectoryWatcher::wait(vector<string>& changed, vector<string>& removed, int quietMilliseconds)
+{
+	changed.clear();
+	removed.clear();
+	if (_notify >= 0)
+		return waitForEvents(changed, removed, quietMilliseconds);
+	return waitForScan(changed, removed, quietMilliseconds);
+}
+
+#ifdef __linux__
+
+bool DirectoryWatcher::waitForEvents(vector<string>& changed, vector<string>& removed, int quietMilliseconds)
+{
+	set<string> names, gone;
+	chrono::steady_clock::time_point lastChange;
+	char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	while (true)
+	{
+		// nothing pending waits for the next save, otherwise for the quiet time
+		int timeout = -1;
+		if (!names.empty() || !gone.empty())
+		{
+			long long elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - lastChange).count();
+			timeout = (int) max(quietMilliseconds - elapsed, 0LL);
+		}
+		struct pollfd ready;
+		ready.fd = _notify;
+		ready.events = POLLIN;
+		ready.revents = 0;
+		int result = poll(&ready, 1, timeout);
+		if (result < 0 && errno == EINTR)
+			continue;
+		if (result < 0)
+			return false;
+		if (result == 0)
+			break;
+
+		ssize_t length = read(_notify, buffer, sizeof(buffer));
+		if (length < 0 && errno == EINTR)
+			continue;
+		if (length <= 0)
+			return false;
+		for (char* next = buffer; next < buffer + length; )
+		{
+			const struct inotify_event* event = (const struct inotify_event*) next;
+			next += sizeof(struct inotify_event) + event->len;
+			// the directory itself was removed or renamed
+			if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+				return false;
+			// writes of other files, such as the translations, do not delay the report
+			if (event->len == 0 || !isSBMLFileName(event->name))
+				continue;
+			// the last of the events of a file decides, a file renamed away
+			// and written anew was saved
+			if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+			{
+				names.erase(event->name);
+				gone.insert(event->name);
+			}
+			else
+			{
+				gone.erase(event->name);
+				names.insert(event->name);
+			}
+			lastChange = chrono::steady_clock::now();
+		}
+	}
+
+	for (set<string>::const_iterator name = names.begin(); name != names.end(); ++name)
+	{
+		changed.push_back(_directory + "/" + *name);
+	}
+	for (set<string>::const_iterator name = gone.begin(); name != gone.end(); ++name)
+	{
+		removed.push_back(_directory + "/" + *name);
+	}
+	return true;
+}
+
+#else
+
+bool DirectoryWatcher::waitForEvents(vector<string>& changed, vector<string>& removed, int quietMilliseconds)
+{
+	return false;
+}
+
+#endif
+
+bool DirectoryWatcher::waitForScan(vector<string>& changed, vector<string>& removed, int quietMilliseconds)
+{
+	set<string> names, gone;
+	chrono::steady_clock::time_point lastChange;
+	while (true)
+	{
+		this_thread::sleep_for(chrono::milliseconds(SCAN_INTERVAL_MS));
+		TSnapshot current;
+		if (!scan(current))
+			return false;
+
+		bool bChanged = false;
+		for (TSnapshot::const_iterator file = current.begin(); file != current.end(); ++file)
+		{
+			TSnapshot::const_iterator before = _snapshot.find(file->first);
+			if (before == _snapshot.end() || before->second.modified != file->second.modified
+				|| before->second.size != file->second.size)
+			{
+				gone.erase(file->first);
+				names.insert(file->first);
+				bChanged = true;
+			}
+		}
+		for (TSnapshot::const_iterator file = _snapshot.begin(); file != _snapshot.end(); ++file)
+		{
+			if (current.find(file->first) == current.end())
+			{
+				names.erase(file->first);
+				gone.insert(file->first);
+				bChanged = true;
+			}
+		}
+		_snapshot.swap(current);
+
+		if (bChanged)
+			lastChange = chrono::steady_clock::now();
+		else if ((!names.empty() || !gone.empty())
+			&& chrono::steady_clock::now() - lastChange >= chrono::milliseconds(quietMilliseconds))
+			break;
+	}
+	changed.assign(names.begin(), names.end());
+	removed.assign(gone.begin(), gone.end());
+	return true;
+}
+
+bool DirectoryWatcher::scan(TSnapshot& snapshot) const
+{
+	vector<TBatchInput> inputs;
+	string error;
+	if (!listBatchInputs(_directory, inputs, error))
+		return false;
+	for (size_t i = 0; i < inputs.size(); i++)
+	{
+		struct stat info;
+		if (stat(inputs[i].fileName.c_str(), &info) != 0)
+			continue;
+		TFileState& state = snapshot[inputs[i].fileName];
+		state.modified = (long long) info.st_mtime;
+		state.size = inputs[i].size;
+	}
+	return true;
+}
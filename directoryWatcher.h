@@ -0,0 +1,95 @@
+/**
+* @file directoryWatcher.h
+* @brief Tells which SBML files of a directory were saved
+*
+*/
+
+/* 
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the University of Washington nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
+
+#ifndef DIRECTORY_WATCHER_H
+#define DIRECTORY_WATCHER_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+/** @brief Waits for the SBML files of a directory to be written
+*
+* On Linux the directory is watched with inotify. Elsewhere, or where
+* inotify cannot be used, it is scanned a couple of times a second and
+* compared with the scan before, by the modification time and size of its
+* files.
+*/
+class DirectoryWatcher
+{
+public:
+	/** @brief Starts watching a directory
+	*
+	* @param[in] directory The directory to watch
+	* @param[out] error Why the directory cannot be watched
+	* @return the watcher, or NULL if the directory cannot be watched
+	*/
+	static DirectoryWatcher* open(const std::string& directory, std::string& error);
+
+	~DirectoryWatcher();
+
+	/** @brief Waits until SBML files were written or removed and then left alone for a while
+	*
+	* A file saved several times in a row, or in several writes, is reported
+	* once, after it has not been written to for quietMilliseconds. A file
+	* deleted or renamed away is reported as removed, unless it was written
+	* again before the report.
+	*
+	* @param[out] changed The files written, their directory included
+	* @param[out] removed The files gone, their directory included
+	* @param[in] quietMilliseconds How long the files have to be left alone
+	* @return false if the directory can no longer be watched
+	*/
+	bool wait(std::vector<std::string>& changed, std::vector<std::string>& removed, int quietMilliseconds);
+
+private:
+	typedef struct {
+		long long modified;
+		unsigned long long size;
+	} TFileState;
+
+	typedef std::map<std::string, TFileState> TSnapshot;
+
+	DirectoryWatcher(const std::string& directory);
+	DirectoryWatcher(const DirectoryWatcher&);
+	DirectoryWatcher& operator=(const DirectoryWatcher&);
+
+	bool waitForEvents(std::vector<std::string>& changed, std::vector<std::string>& removed, int quietMilliseconds);
+	bool waitForScan(std::vector<std::string>& changed, std::vector<std::string>& removed, int quietMilliseconds);
+	bool scan(TSnapshot& snapshot) const;
+
+	std::string _directory;
+	int _notify; // the inotify descriptor, -1 when scanning
+	TSnapshot _snapshot; // the last scan
+};
+
+#endif
@@ -0,0 +1,419 @@
+/**
+* @file omexArchive.cpp
+* @brief Reads the SBML models of COMBINE/OMEX archives straight from the zip
+*
+*/
+
+/* 
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the University of Washington nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
+
+#include "omexArchive.h"
+
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <sbml/SBMLTypes.h>
+
+#ifdef SBML2MATLAB_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace std;
+
+static const unsigned int LOCAL_HEADER_SIGNATURE = 0x04034b50;
+static const unsigned int CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+static const unsigned int END_OF_DIRECTORY_SIGNATURE = 0x06054b50;
+
+// the end of central directory record is 22 bytes plus a comment of up to 64k
+static const size_t END_OF_DIRECTORY_SIZE = 22;
+static const size_t MAX_COMMENT_SIZE = 65535;
+
+static const size_t LOCAL_HEADER_SIZE = 30;
+
+// entries are read and inflated this much at a time
+static const size_t CHUNK_SIZE = 64 * 1024;
+
+// no SBML model comes anywhere near this, larger sizes in an archive are
+// damaged or hostile
+static const unsigned long long MAX_ENTRY_SIZE = 1ULL << 30;
+
+static const char* MANIFEST_NAME = "manifest.xml";
+static const char* SBML_FORMAT = "identifiers.org/combine.specifications/sbml";
+
+static unsigned int readShort(const unsigned char* data)
+{
+	return data[0] | (data[1] << 8);
+}
+
+static unsigned int readInt(const unsigned char* data)
+{
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned int) data[3] << 24);
+}
+
+// locations in the manifest are relative to the archive root, often with a leading ./
+static string normalizeLocation(const string& location)
+{
+	string result(location);
+	while (result.compare(0, 2, "./") == 0)
+		result.erase(0, 2);
+	while (!result.empty() && result[0] == '/')
+		result.erase(0, 1);
+	return result;
+}
+
+// collects the content elements of the manifest, wherever they are nested
+static void findContent(const XMLNode& node, vector<XMLNode>& content)
+{
+	for (unsigned int i = 0; i < node.getNumChildren(); i++)
+	{
+		const XMLNode& child = node.getChild(i);
+		if (!child.isElement())
+			continue;
+		if (child.getName() == "content")
+			content.push_back(child);
+		else
+			findContent(child, content);
+	}
+}
+
+OmexArchive::OmexArchive(const string& fileName)
+  : _fileName(fileName)
+  , _fileSize(0)
+  , _models()
+{
+}
+
+OmexArchive* OmexArchive::open(const string& fileName, string& error)
+{
+	OmexArchive* archive = new OmexArchive(fileName);
+	vector<TEntry> entries;
+	if (!archive->readDirectory(entries, error))
+	{
+		delete archive;
+		return NULL;
+	}
+
+	const TEntry* manifestEntry = NULL;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (entries[i].location == MANIFEST_NAME)
+			manifestEntry = &entries[i];
+	}
+	if (manifestEntry == NULL)
+	{
+		error = "the archive has no manifest.xml";
+		delete archive;
+		return NULL;
+	}
+
+	string manifest;
+	if (!archive->read(*manifestEntry, manifest, error))
+	{
+		delete archive;
+		return NULL;
+	}
+
+	// the XML declaration is not accepted by convertStringToXMLNode
+	if (manifest.compare(0, 5, "<?xml") == 0)
+	{
+		size_t end = manifest.find("?>");
+		manifest.erase(0, end == string::npos ? manifest.length() : end + 2);
+	}
+	XMLNode* root = XMLNode::convertStringToXMLNode(manifest);
+	if (root == NULL)
+	{
+		error = "the manifest.xml of the archive cannot be read";
+		delete archive;
+		return NULL;
+	}
+
+	vector<XMLNode> content;
+	if (root->getName() == "content")
+		content.push_back(*root);
+	else
+		findContent(*root, content);
+	delete root;
+
+	for (size_t i = 0; i < content.size(); i++)
+	{
+		if (content[i].getAttrValue("format").find(SBML_FORMAT) == string::npos)
+			continue;
+
+		string location = normalizeLocation(content[i].getAttrValue("location"));
+		bool found = false;
+		for (size_t j = 0; j < entries.size() && !found; j++)
+		{
+			if (entries[j].location == location)
+			{
+				archive->_models.push_back(entries[j]);
+				found = true;
+			}
+		}
+		if (!found)
+		{
+			error = "the manifest lists '" + location + "', which is not in the archive";
+			delete archive;
+			return NULL;
+		}
+	}
+	return archive;
+}
+
+bool OmexArchive::isArchive(const string& fileName)
+{
+	OmexArchive archive(fileName);
+	vector<TEntry> entries;
+	string error;
+	if (!archive.readDirectory(entries, error))
+		return false;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (entries[i].location == MANIFEST_NAME)
+			return true;
+	}
+	return false;
+}
+
+// reads the central directory of the zip file
+bool OmexArchive::readDirectory(vector<TEntry>& entries, string& error)
+{
+	ifstream file(_fileName.c_str(), ios::in | ios::binary);
+	if (!file.is_open())
+	{
+		error = "the archive cannot be opened";
+		return false;
+	}
+
+	file.seekg(0, ios::end);
+	streamoff endPosition = file.tellg();
+	if (endPosition < (streamoff) END_OF_DIRECTORY_SIZE)
+	{
+		error = "the archive is not a zip file";
+		return false;
+	}
+	unsigned long long fileSize = (unsigned long long) endPosition;
+	_fileSize = fileSize;
+	size_t tailSize = (size_t) min<unsigned long long>(fileSize, END_OF_DIRECTORY_SIZE + MAX_COMMENT_SIZE);
+	vector<unsigned char> tail(tailSize);
+	file.seekg((streamoff) (fileSize - tailSize), ios::beg);
+	file.read((char*) &tail[0], tailSize);
+	if (!file || tailSize < END_OF_DIRECTORY_SIZE)
+	{
+		error = "the archive is not a zip file";
+		return false;
+	}
+
+	size_t end = tailSize - END_OF_DIRECTORY_SIZE + 1;
+	bool found = false;
+	while (end > 0 && !found)
+	{
+		end--;
+		found = readInt(&tail[end]) == END_OF_DIRECTORY_SIGNATURE;
+	}
+	if (!found)
+	{
+		error = "the archive is not a zip file";
+		return false;
+	}
+
+	unsigned int numEntries = readShort(&tail[end + 10]);
+	unsigned int directorySize = readInt(&tail[end + 12]);
+	unsigned int directoryOffset = readInt(&tail[end + 16]);
+	if (numEntries == 0xffff || directoryOffset == 0xffffffff)
+	{
+		error = "zip64 archives are not supported";
+		return false;
+	}
+	if ((unsigned long long) directoryOffset + directorySize > fileSize)
+	{
+		error = "the central directory of the archive is damaged";
+		return false;
+	}
+
+	vector<unsigned char> directory(directorySize + 1);
+	file.seekg(directoryOffset, ios::beg);
+	file.read((char*) &directory[0], directorySize);
+	if (!file)
+	{
+		error = "the central directory of the archive cannot be read";
+		return false;
+	}
+
+	size_t position = 0;
+	for (unsigned int i = 0; i < numEntries; i++)
+	{
+		if (position + 46 > directorySize || readInt(&directory[position]) != CENTRAL_HEADER_SIGNATURE)
+		{
+			error = "the central directory of the archive is damaged";
+			return false;
+		}
+
+		const unsigned char* header = &directory[position];
+		size_t nameLength = readShort(header + 28);
+		size_t extraLength = readShort(header + 30);
+		size_t commentLength = readShort(header + 32);
+		if (position + 46 + nameLength > directorySize)
+		{
+			error = "the central directory of the archive is damaged";
+			return false;
+		}
+
+		TEntry entry;
+		entry.method = (unsigned short) readShort(header + 10);
+		entry.crc = readInt(header + 16);
+		entry.compressedSize = readInt(header + 20);
+		entry.size = readInt(header + 24);
+		entry.headerOffset = readInt(header + 42);
+		entry.location = normalizeLocation(string((const char*) header + 46, nameLength));
+		entries.push_back(entry);
+
+		position += 46 + nameLength + extraLength + commentLength;
+	}
+	return true;
+}
+
+bool OmexArchive::read(const TEntry& entry, string& content, string& error) const
+{
+	// the sizes come from the archive, so they are checked before anything
+	// is read and the content only grows as data is actually inflated
+	if (entry.headerOffset + LOCAL_HEADER_SIZE > _fileSize
+		|| entry.compressedSize > _fileSize - entry.headerOffset - LOCAL_HEADER_SIZE
+		|| (entry.method == 0 && entry.size != entry.compressedSize))
+	{
+		error = "the entry '" + entry.location + "' is damaged";
+		return false;
+	}
+	if (entry.size > MAX_ENTRY_SIZE)
+	{
+		error = "the entry '" + entry.location + "' is too large";
+		return false;
+	}
+	if (entry.method != 0 && entry.method != 8)
+	{
+		error = "the entry '" + entry.location + "' uses an unsupported compression method";
+		return false;
+	}
+#ifndef SBML2MATLAB_WITH_ZLIB
+	if (entry.method == 8)
+	{
+		error = "the entry '" + entry.location + "' is compressed, but sbml2matlab was built without zlib";
+		return false;
+	}
+#endif
+
+	ifstream file(_fileName.c_str(), ios::in | ios::binary);
+	unsigned char header[LOCAL_HEADER_SIZE];
+	file.seekg((streamoff) entry.headerOffset, ios::beg);
+	file.read((char*) header, sizeof(header));
+	if (!file || readInt(header) != LOCAL_HEADER_SIGNATURE)
+	{
+		error = "the entry '" + entry.location + "' is damaged";
+		return false;
+	}
+	file.seekg(readShort(header + 26) + readShort(header + 28), ios::cur);
+
+	content.clear();
+	vector<char> input(CHUNK_SIZE);
+#ifdef SBML2MATLAB_WITH_ZLIB
+	vector<char> output(CHUNK_SIZE);
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	int status = Z_OK;
+	// raw deflate data, zip files carry no zlib header
+	if (entry.method == 8 && inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+	{
+		error = "zlib cannot be initialized";
+		return false;
+	}
+#endif
+
+	bool bFailed = false;
+	unsigned long long remaining = entry.compressedSize;
+	while (remaining > 0 && !bFailed)
+	{
+		size_t length = (size_t) min<unsigned long long>(remaining, CHUNK_SIZE);
+		file.read(&input[0], (streamsize) length);
+		if (!file)
+		{
+			error = "the entry '" + entry.location + "' is truncated";
+			bFailed = true;
+			break;
+		}
+		remaining -= length;
+
+		if (entry.method == 0)
+		{
+			content.append(&input[0], length);
+			continue;
+		}
+#ifdef SBML2MATLAB_WITH_ZLIB
+		stream.next_in = (Bytef*) &input[0];
+		stream.avail_in = (uInt) length;
+		do
+		{
+			stream.next_out = (Bytef*) &output[0];
+			stream.avail_out = (uInt) output.size();
+			status = inflate(&stream, Z_NO_FLUSH);
+			size_t produced = output.size() - stream.avail_out;
+			if ((status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR)
+				|| content.length() + produced > entry.size)
+			{
+				bFailed = true;
+				break;
+			}
+			content.append(&output[0], produced);
+		} while (stream.avail_out == 0 && status != Z_STREAM_END);
+		if (bFailed)
+			error = "the entry '" + entry.location + "' cannot be inflated";
+#endif
+	}
+
+#ifdef SBML2MATLAB_WITH_ZLIB
+	if (entry.method == 8)
+	{
+		inflateEnd(&stream);
+		if (!bFailed && (status != Z_STREAM_END || content.length() != entry.size))
+		{
+			error = "the entry '" + entry.location + "' cannot be inflated";
+			bFailed = true;
+		}
+	}
+#endif
+	if (bFailed)
+	{
+		content.clear();
+		return false;
+	}
+
+#ifdef SBML2MATLAB_WITH_ZLIB
+	if (crc32(crc32(0L, Z_NULL, 0), (const Bytef*) content.data(), (uInt) content.length()) != entry.crc)
+	{
+		error = "the entry '" + entry.location + "' fails its checksum";
+		return false;
+	}
+#endif
+	return true;
+}
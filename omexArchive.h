@@ -0,0 +1,94 @@
+/**
+* @file omexArchive.h
+* @brief Reads the SBML models of COMBINE/OMEX archives straight from the zip
+*
+*/
+
+/* 
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the University of Washington nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
+
+#ifndef OMEX_ARCHIVE_H
+#define OMEX_ARCHIVE_H
+
+#include <string>
+#include <vector>
+
+/** @brief A COMBINE/OMEX archive, a zip file with a manifest listing its content
+*
+* Only the central directory and the manifest are read when the archive is
+* opened. Entries are inflated into memory on request, so nothing is ever
+* extracted to disk. Entries are inflated in bounded chunks and their sizes
+* are checked against the archive, so a damaged archive cannot make the
+* reader allocate more than its content. Entries can be read from several
+* threads at once.
+*/
+class OmexArchive
+{
+public:
+	/** @brief An SBML model listed in the manifest */
+	typedef struct {
+		std::string location; /**< Path of the entry within the archive */
+		unsigned short method; /**< 0 stored, 8 deflated */
+		unsigned int crc;
+		unsigned long long compressedSize;
+		unsigned long long size;
+		unsigned long long headerOffset; /**< Offset of the local file header */
+	} TEntry;
+
+	/** @brief Opens an archive and reads its manifest
+	*
+	* @param[in] fileName The archive file
+	* @param[out] error Why the archive could not be opened
+	* @return the archive, or NULL on an error
+	*/
+	static OmexArchive* open(const std::string& fileName, std::string& error);
+
+	/** @brief Returns true if the given zip file has a manifest.xml */
+	static bool isArchive(const std::string& fileName);
+
+	/** @brief The SBML models listed in the manifest, in manifest order */
+	const std::vector<TEntry>& models() const { return _models; }
+
+	/** @brief Inflates an entry into memory
+	*
+	* @param[in] entry One of the entries returned by models
+	* @param[out] content The content of the entry
+	* @param[out] error Why the entry could not be read
+	* @return true on success
+	*/
+	bool read(const TEntry& entry, std::string& content, std::string& error) const;
+
+private:
+	OmexArchive(const std::string& fileName);
+
+	bool readDirectory(std::vector<TEntry>& entries, std::string& error);
+
+	std::string				_fileName;
+	unsigned long long		_fileSize; /**< Measured by readDirectory */
+	std::vector<TEntry>		_models;
+};
+
+#endif
@@ -31,11 +31,22 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <sstream>
 #include <clocale>
 #include <exception>
+#include <unordered_map>
+#include <iterator>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <chrono>
 
 #ifdef WIN32
 #ifndef CYGWIN
 #define strdup _strdup
 #endif
+#include <io.h>
+#include <fcntl.h>
 #endif
 
 #define CONVERT_ANY(source,target)\
@@ -48,6 +59,18 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "uScanner.h"
 #include "NOM.h"
+#include "translationCache.h"
+#include "contentHash.h"
+#include "omexArchive.h"
+#include "threadPool.h"
+#include "batchInputs.h"
+#include "boundedQueue.h"
+#include "batchJournal.h"
+#include "translationServer.h"
+#include "workerPool.h"
+#include "directoryWatcher.h"
+
+#define SBML2MATLAB_VERSION "1.1.1"
 
 using namespace uScanner;
 using namespace std;
@@ -103,6 +126,145 @@ public:
 };
 
 
+// kinds of values a translation can be patched with
+enum TValueKind
+{
+	VALUE_COMPARTMENT,
+	VALUE_GLOBAL_PARAMETER,
+	VALUE_FLOATING_SPECIES,
+	VALUE_BOUNDARY_SPECIES
+};
+
+// where the literal of a value was written into a translation
+typedef struct {
+	string id;
+	size_t offset;
+	size_t length;
+} TValueSpan;
+
+typedef struct {
+	int kind;
+	double value;
+} TPatchableValue;
+
+// looks up a model map without inserting into it, missing keys read as
+// the default value; the maps are shared by rows printed in parallel
+template <class TMap>
+static typename TMap::mapped_type lookupValue(const TMap &values, const typename TMap::key_type &key)
+{
+	typename TMap::const_iterator it = values.find(key);
+	return it != values.end() ? it->second : typename TMap::mapped_type();
+}
+
+// a reaction a floating species takes part in
+typedef struct {
+	int reaction;
+	double productStoichiometry;
+	double reactantStoichiometry;
+	string terms; // the terms of the reaction in the rate of change, e.g. " + 2*R3"
+} TSpeciesReaction;
+
+
+// remembers the MATLAB fragments printed for model elements so a session
+// only has to print the elements that changed since its last translation,
+// rows printed in parallel share it
+class TFragmentMemo
+{
+public:
+	TFragmentMemo()
+      : _lock()
+      , _previous()
+      , _current()
+	{
+	}
+
+	// looks up the fragment printed for the given source
+	bool lookup(const string &source, string &fragment)
+	{
+		lock_guard<mutex> lock(_lock);
+		unsigned long long key = fnv1a64(source.data(), source.length());
+		TFragments::iterator entry = _current.find(key);
+		if (entry != _current.end() && entry->second.source == source)
+		{
+			fragment = entry->second.fragment;
+			return true;
+		}
+		entry = _previous.find(key);
+		if (entry != _previous.end() && entry->second.source == source)
+		{
+			fragment = entry->second.fragment;
+			_current[key] = entry->second;
+			_previous.erase(entry);
+			return true;
+		}
+		return false;
+	}
+
+	void store(const string &source, const string &fragment)
+	{
+		lock_guard<mutex> lock(_lock);
+		TFragment &entry = _current[fnv1a64(source.data(), source.length())];
+		entry.source = source;
+		entry.fragment = fragment;
+	}
+
+	// drops the fragments that were not used since the last call
+	void endTranslation()
+	{
+		_previous.swap(_current);
+		_current.clear();
+	}
+
+	void clear()
+	{
+		_previous.clear();
+		_current.clear();
+	}
+
+private:
+	typedef struct {
+		string source;
+		string fragment;
+	} TFragment;
+
+	typedef unordered_map<unsigned long long, TFragment> TFragments;
+
+	mutex _lock;
+	TFragments _previous;
+	TFragments _current;
+};
+
+
+// compression of an input file, told apart by its first bytes
+enum TCompression
+{
+	COMPRESSION_NONE,
+	COMPRESSION_GZIP,
+	COMPRESSION_BZIP2,
+	COMPRESSION_ZIP
+};
+
+static TCompression detectCompression(const unsigned char *header, size_t length)
+{
+	if (length >= 2 && header[0] == 0x1f && header[1] == 0x8b)
+		return COMPRESSION_GZIP;
+	if (length >= 3 && header[0] == 'B' && header[1] == 'Z' && header[2] == 'h')
+		return COMPRESSION_BZIP2;
+	if (length >= 4 && header[0] == 'P' && header[1] == 'K' && header[2] == 0x03 && header[3] == 0x04)
+		return COMPRESSION_ZIP;
+	return COMPRESSION_NONE;
+}
+
+// libSBML picks its decompressing reader by the file extension
+static bool hasCompressionExtension(const string &fileName, TCompression compression)
+{
+	const char *extensions[] = { "", ".gz", ".bz2", ".zip" };
+	string extension(extensions[compression]);
+	return fileName.length() >= extension.length()
+		&& fileName.compare(fileName.length() - extension.length(), extension.length(), extension) == 0;
+}
+
+
 class MatlabError
 	: public std::exception
 {
@@ -119,6 +281,66 @@ private:
 };
 
 
+// stops a translation once its cancellation flag is set and reports how
+// far it has got, as its options ask for
+class TranslationMonitor
+{
+public:
+	TranslationMonitor()
+      : _cancelFlag(NULL)
+      , _progress(NULL)
+      , _progressData(NULL)
+      , _reportLock()
+	{
+	}
+
+	void setOptions(const TranslationOptions &options)
+	{
+		_cancelFlag = options.cancelFlag;
+		_progress = options.progress;
+		_progressData = options.progressData;
+	}
+
+	// throws once the translation is cancelled
+	void check() const
+	{
+		if (_cancelFlag != NULL && *_cancelFlag != 0)
+			throw new MatlabError("The translation was cancelled");
+	}
+
+	// checks for cancellation, and reports every few items that done of the
+	// total items of a stage are finished
+	void advance(const char *stage, int done, int total)
+	{
+		check();
+		if (_progress == NULL || (done % PROGRESS_INTERVAL != 0 && done != total))
+			return;
+		lock_guard<mutex> lock(_reportLock);
+		_progress(stage, done, total, _progressData);
+	}
+
+	// as advance, for items finished in parallel; done is counted under the
+	// same lock the report is made under, so reports never go backwards
+	void advanceShared(const char *stage, int *done, int total)
+	{
+		check();
+		if (_progress == NULL)
+			return;
+		lock_guard<mutex> lock(_reportLock);
+		int current = ++*done;
+		if (current % PROGRESS_INTERVAL == 0 || current == total)
+			_progress(stage, current, total, _progressData);
+	}
+
+private:
+	static const int PROGRESS_INTERVAL = 64;
+
+	const volatile int *_cancelFlag;
+	TranslationProgressCallback _progress;
+	void *_progressData;
+	mutex _reportLock; // rows printed in parallel are counted and reported one at a time
+};
+
 class TReactionInfo
 {
 public: 
@@ -133,7 +355,7 @@ public:
 	vector<TNameValue> products;
 	vector<TNameValue> parameters;
 
-	TReactionInfo (int reactionIndex)
+	TReactionInfo (NOMContext *ctx, int reactionIndex)
       : id("")
       , name("")
       , isReversible(false)
@@ -145,41 +367,41 @@ public:
 	{
 		char *cId;
 
-		getNthReactionId (reactionIndex, &cId);
+		nom_getNthReactionId(ctx, reactionIndex, &cId);
 		id = cId; 
-		getNthReactionName (reactionIndex, &cId);
+		nom_getNthReactionName(ctx, reactionIndex, &cId);
 		name = cId;
-		isReactionReversible (reactionIndex, &iIsReve);
+		nom_isReactionReversible(ctx, reactionIndex, &iIsReve);
 		isReversible = (bool) iIsReve;
-		getKineticLaw (reactionIndex, &cId);
+		nom_getKineticLaw(ctx, reactionIndex, &cId);
 		rateLaw = cId;
 		int numOfReactants; int numOfProducts; 
 		int numParameters;  double value;
 
-		numOfReactants = getNumReactants (reactionIndex);
+		numOfReactants = nom_getNumReactants(ctx, reactionIndex);
 		for (int i=0; i<numOfReactants; i++) {
 			TNameValue reactant;
-			getNthReactantName (reactionIndex, i, &cId);
+			nom_getNthReactantName(ctx, reactionIndex, i, &cId);
 			reactant.name = cId;
-			reactant.value = getNthReactantStoichiometry (reactionIndex, i);
+			reactant.value = nom_getNthReactantStoichiometry(ctx, reactionIndex, i);
 			reactants.push_back(reactant);
 		}
 
-		numOfProducts = getNumProducts (reactionIndex);
+		numOfProducts = nom_getNumProducts(ctx, reactionIndex);
 		for (int i=0; i<numOfProducts; i++) {
 			TNameValue reactant;
-			getNthProductName (reactionIndex, i, &cId);
+			nom_getNthProductName(ctx, reactionIndex, i, &cId);
 			reactant.name = cId;
-			reactant.value = getNthProductStoichiometry (reactionIndex, i);
+			reactant.value = nom_getNthProductStoichiometry(ctx, reactionIndex, i);
 			products.push_back(reactant);
 		}
 
-		numParameters = getNumLocalParameters (reactionIndex);
+		numParameters = nom_getNumLocalParameters(ctx, reactionIndex);
 		for (int i=0; i<numParameters; i++) {
 			TNameValue parameter;
-			getNthLocalParameterId (reactionIndex, i, &cId);
+			nom_getNthLocalParameterId(ctx, reactionIndex, i, &cId);
 			parameter.name = cId;
-			getNthLocalParameterValue (reactionIndex, i, &value);
+			nom_getNthLocalParameterValue(ctx, reactionIndex, i, &value);
 			parameter.value = value;
 			parameters.push_back(parameter);
 		}
@@ -191,8 +413,10 @@ class SBMLInfo
 {
 public: 
 
-    SBMLInfo(const string& sbmlString)
-      : modelName()
+    SBMLInfo(NOMContext *ctx, const string& sbmlString)
+      : _ctx(ctx)
+      , _monitor(NULL)
+      , modelName()
       , numFloatingSpecies(0)
       , numReactions(0)
       , numBoundarySpecies(0)
@@ -217,32 +441,60 @@ public:
       , compartments()
       , globalParameters()
     {
-        std::string str;
-		char *cstr;
 		char *cstr_sbml;
 
 		cstr_sbml = (char *) sbmlString.c_str(); 
-		loadSBML(cstr_sbml);
-
-		if (!getModelId(&cstr)) {
-          modelName = cstr;
-        }
-		if (modelName == "")
-			modelName = "ExportedModel";
-
-		numFloatingSpecies = getNumFloatingSpecies();
-		numBoundarySpecies = getNumBoundarySpecies();
+		nom_loadSBML(_ctx, cstr_sbml);
+		ReadModel();
+	}
 
-		ReadCompartments();
-		ReadGlobalParameters();
-		ReadUserDefinedFunctions();
-		ReadRules();
-		ReadReactions();		
-		ReadSpecies();
+	// fills the model information straight from a parsed document, which
+	// is handed over to the NOM context so no intermediate SBML string is needed
+    SBMLInfo(NOMContext *ctx, SBMLDocument* oDoc, TranslationMonitor* monitor = NULL)
+      : _ctx(ctx)
+      , _monitor(monitor)
+      , modelName()
+      , numFloatingSpecies(0)
+      , numReactions(0)
+      , numBoundarySpecies(0)
+      , numParameters(0)
+      , numGlobalParameters(0)
+      , numCompartments(0)
+      , numRules(0)
+      , numUserDefinedFunctions(0)
+      , compartmentsList()
+      , localParameterList()
+      , allLocalParametersList()
+      , globalParametersList()
+      , globalParamIndexList()
+      , nthReactionParameters()
+      , parameterMapList()
+      , iterator()
+      , sp_list(NULL)
+      , rules()
+      , ruleTypes()
+      , userDefinedFunctions()
+      , reactions()
+      , compartments()
+      , globalParameters()
+    {
+		nom_loadSBMLDocument(_ctx, oDoc);
+		try
+		{
+			ReadModel();
+		}
+		catch (...)
+		{
+			// a cancelled reading never gets to the destructor
+			delete[] sp_list;
+			throw;
+		}
 	}
 
     SBMLInfo()
-      : modelName()
+      : _ctx(nom_default_context())
+      , _monitor(NULL)
+      , modelName()
       , numFloatingSpecies(0)
       , numReactions(0)
       , numBoundarySpecies(0)
@@ -276,15 +528,37 @@ public:
 	}
 
 
+	// reads all model information from the model currently loaded in the NOM context
+	void ReadModel()
+	{
+		char *cstr;
+
+		if (!nom_getModelId(_ctx, &cstr)) {
+          modelName = cstr;
+        }
+		if (modelName == "")
+			modelName = "ExportedModel";
+
+		numFloatingSpecies = nom_getNumFloatingSpecies(_ctx);
+		numBoundarySpecies = nom_getNumBoundarySpecies(_ctx);
+
+		ReadCompartments();
+		ReadGlobalParameters();
+		ReadUserDefinedFunctions();
+		ReadRules();
+		ReadReactions();		
+		ReadSpecies();
+	}
+
 
 	void ReadUserDefinedFunctions()
 	{
-		numUserDefinedFunctions = getNumFunctionDefinitions();
+		numUserDefinedFunctions = nom_getNumFunctionDefinitions(_ctx);
 		char* fnId; int numArgs; char** argList; char* body;
 
 		for (int i = 0; i < numUserDefinedFunctions; i++)
 		{
-			getNthFunctionDefinition(i, &fnId, &numArgs, &argList, &body);
+			nom_getNthFunctionDefinition(_ctx, i, &fnId, &numArgs, &argList, &body);
 			TUserFuncInfo *userStruct = (TUserFuncInfo *) malloc (sizeof (TUserFuncInfo));
 
 			userStruct->fnId = fnId;
@@ -297,14 +571,14 @@ public:
 
 	void ReadRules()
 	{
-		numRules = getNumRules();
+		numRules = nom_getNumRules(_ctx);
 
 		char *cstr;
 		int ruleType;
 
 		for (int i = 0; i < numRules; i++)
 		{
-			getNthRule (i, &cstr, &ruleType);
+			nom_getNthRule(_ctx, i, &cstr, &ruleType);
 			ruleTypes.push_back (ruleType);
 			rules.push_back (cstr);
 		}
@@ -312,10 +586,12 @@ public:
 
 	void ReadReactions()
 	{
-		numReactions = getNumReactions();
+		numReactions = nom_getNumReactions(_ctx);
 		for (int i = 0; i < numReactions; i++)
 		{
-			reactions.push_back(TReactionInfo(i));
+			reactions.push_back(TReactionInfo(_ctx, i));
+			if (_monitor != NULL)
+				_monitor->advance("reading reactions", i + 1, numReactions);
 		}
 	}
 
@@ -323,17 +599,17 @@ public:
 	{
 		char *cstr;
 
-		numCompartments = getNumCompartments();
+		numCompartments = nom_getNumCompartments(_ctx);
 		for (int i = 0; i < numCompartments; i++)
 		{
 			IdNameValue compartment;
 
-			getNthCompartmentId(i, &cstr);
+			nom_getNthCompartmentId(_ctx, i, &cstr);
 			compartment.id = cstr;
-			getNthCompartmentName(i, &cstr);
+			nom_getNthCompartmentName(_ctx, i, &cstr);
 			compartment.name = cstr;
 			cstr = (char*) compartment.id.c_str();
-			getValue(cstr, &compartment.value);
+			nom_getValue(_ctx, cstr, &compartment.value);
 
 			compartments.push_back(compartment);
 			compartmentsList[compartment.id] = compartment.value;
@@ -344,15 +620,15 @@ public:
 	{
 		char * cstr;
 
-		numGlobalParameters = getNumGlobalParameters();
+		numGlobalParameters = nom_getNumGlobalParameters(_ctx);
 		for (int i = 0; i < numGlobalParameters; i++)
 		{
 			NameValue parameter;
-			getNthGlobalParameterId(i, &cstr);
+			nom_getNthGlobalParameterId(_ctx, i, &cstr);
 			parameter.name = cstr;
 
 			cstr = (char*) parameter.name.c_str();
-			getValue(cstr, &parameter.value);
+			nom_getValue(_ctx, cstr, &parameter.value);
 			globalParameters.push_back(parameter);
 
 			globalParametersList[parameter.name] = parameter.value;
@@ -379,21 +655,23 @@ public:
 
 		for (int i=0; i<numFloatingSpecies; i++) 
 		{
-			getNthFloatingSpeciesId (i, &cstr);
+			if (_monitor != NULL)
+				_monitor->advance("reading species", i + 1, numTotalSpecies);
+			nom_getNthFloatingSpeciesId(_ctx, i, &cstr);
 			sp_list[i].id = cstr;
 
 			double value; 
-			getValue (cstr, &value);
+			nom_getValue(_ctx, cstr, &value);
 			bool isConcentration;
 			bool isAmount;
 
-			getNthFloatingSpeciesName(i, &cstr);
+			nom_getNthFloatingSpeciesName(_ctx, i, &cstr);
 			sp_list[i].name = cstr;
-			getCompartmentIdBySpeciesId((char *) sp_list[i].id.c_str(), &cstr);  
+			nom_getCompartmentIdBySpeciesId(_ctx, (char *) sp_list[i].id.c_str(), &cstr);  
 			sp_list[i].compartment = cstr;
 			sp_list[i].compartment_vol = compartmentsList[sp_list[i].compartment];
 			sp_list[i].boundary = false;
-			hasInitialAmount((char *) sp_list[i].name.c_str(), &isAmount);
+			nom_hasInitialAmount(_ctx, (char *) sp_list[i].name.c_str(), &isAmount);
 			isConcentration = !isAmount;
 
 
@@ -415,25 +693,27 @@ public:
 		{
 
 			int index = i + numFloatingSpecies;
+			if (_monitor != NULL)
+				_monitor->advance("reading species", index + 1, numTotalSpecies);
 
-			getNthBoundarySpeciesId (i, &cstr);
+			nom_getNthBoundarySpeciesId(_ctx, i, &cstr);
 			sp_list[index].id = cstr;
 
 			double value; 
-			getValue (cstr, &value);	
+			nom_getValue(_ctx, cstr, &value);	
 			bool isConcentration; 
 			bool isAmount; 
-			hasInitialAmount(cstr, &isAmount);
+			nom_hasInitialAmount(_ctx, cstr, &isAmount);
 			isConcentration = !isAmount;
 
-			getNthBoundarySpeciesName(i, &cstr);
+			nom_getNthBoundarySpeciesName(_ctx, i, &cstr);
 			sp_list[index].name = cstr;
-			getCompartmentIdBySpeciesId((char *) sp_list[index].id.c_str(), &cstr);
+			nom_getCompartmentIdBySpeciesId(_ctx, (char *) sp_list[index].id.c_str(), &cstr);
 			sp_list[index].compartment = cstr;
 			sp_list[index].compartment_vol = compartmentsList[sp_list[index].compartment];
 			sp_list[index].boundary = true;
 
-			if (!hasInitialAmount((char *) sp_list[i].name.c_str(), &isConcentration))
+			if (!nom_hasInitialAmount(_ctx, (char *) sp_list[i].name.c_str(), &isConcentration))
 			{
 				sp_list[index].is_amount = false;
 				sp_list[index].init_conc = value;
@@ -449,6 +729,9 @@ public:
 	}
 
 
+	NOMContext*							_ctx; // the NOM context the model is loaded into
+	TranslationMonitor*					_monitor; // NULL when nobody watches the reading
+
 	string modelName;
 
 	int									numFloatingSpecies;
@@ -481,6 +764,99 @@ public:
 
 };
 
+/*
+* MatlabTranslation
+* a finished translation that remembers where the values of compartments,
+* global parameters and species were written, so new values can be patched
+* in without translating the model again
+*/
+struct MatlabTranslation
+{
+	string								text;
+	string								error;
+	vector<TValueSpan>					spans; // in the order they appear in the text
+	map<string, TPatchableValue>		values;
+	bool								bInline;
+
+	MatlabTranslation()
+      : text()
+      , error()
+      , spans()
+      , values()
+      , bInline(false)
+	{
+	}
+
+	// replaces the literals of the given values, anything that would change
+	// the equations rather than just the numbers is rejected
+	int updateValues(int numValues, const char** ids, const double* newValues)
+	{
+		map<string, double> updates;
+		for (int i = 0; i < numValues; i++)
+		{
+			if (ids[i] == NULL)
+			{
+				error = "missing id in the list of values";
+				return -1;
+			}
+
+			string id(ids[i]);
+			map<string, TPatchableValue>::iterator value = values.find(id);
+			if (value == values.end())
+			{
+				error = "'" + id + "' is not a compartment, global parameter or species of the model";
+				return -1;
+			}
+			if (bInline && (value->second.kind == VALUE_GLOBAL_PARAMETER || value->second.kind == VALUE_BOUNDARY_SPECIES))
+			{
+				error = "'" + id + "' is inlined into the equations, the model has to be translated again";
+				return -1;
+			}
+			// unit volumes are left out of the equations
+			if (value->second.kind == VALUE_COMPARTMENT && (value->second.value == 1.0) != (newValues[i] == 1.0))
+			{
+				error = "changing the volume of '" + id + "' to or from 1 changes the equations, the model has to be translated again";
+				return -1;
+			}
+			updates[id] = newValues[i];
+		}
+
+		string patched;
+		patched.reserve(text.length());
+		size_t last = 0;
+		for (size_t i = 0; i < spans.size(); i++)
+		{
+			TValueSpan& span = spans[i];
+			size_t start = span.offset;
+			patched.append(text, last, start - last);
+			last = start + span.length;
+			span.offset = patched.length();
+
+			map<string, double>::iterator update = updates.find(span.id);
+			if (update == updates.end())
+			{
+				patched.append(text, start, span.length);
+			}
+			else
+			{
+				stringstream literal;
+				literal << update->second;
+				patched += literal.str();
+				span.length = literal.str().length();
+			}
+		}
+		patched.append(text, last, string::npos);
+		text.swap(patched);
+
+		for (map<string, double>::iterator update = updates.begin(); update != updates.end(); ++update)
+		{
+			values[update->first].value = update->second;
+		}
+		error.clear();
+		return 0;
+	}
+};
+
 /*
 * MatlabTranslator
 * this class provides an implementation of the translator service
@@ -489,12 +865,145 @@ class MatlabTranslator
 {
 private:	
 
-	string								sbml, eqn, stoich, pname;
+	string								sbml, stoich, pname;
 	double								pvalue;
 	SBMLInfo*							_currentModel;
+	NOMContext*							_nom; // the NOM context models are loaded into
+	bool								_bOwnsContext;
 
 	//const static string					NL; //Only used in commented-out code.
 	bool                                _bInlineMode;
+	TranslationOptions                  _options;
+
+	vector<TValueSpan>                  _valueSpans;
+	bool                                _bRecordSpans; // whether the value literals printed are recorded
+	streamoff                           _spanOrigin; // where the translation starts in the stream it is printed to
+
+	vector< vector<TSpeciesReaction> >  _speciesReactions; // per floating species
+
+	// fragments kept between translations of a session
+	bool                                _bMemoize;
+	string                              _symbols; // what the memoized rate laws and rules were printed against
+	TFragmentMemo                       _rateLawMemo;
+	TFragmentMemo                       _ruleMemo;
+	TFragmentMemo                       _stoichRowMemo;
+
+	ThreadPool*                         _emitPool; // prints rows and sections side by side, NULL when serial
+	TranslationMonitor                  _monitor;
+
+	typedef void (MatlabTranslator::*TSection)(ostream &);
+	typedef string (MatlabTranslator::*TRow)(int);
+
+	// rows are only split up in blocks of at least this many
+	static const int MIN_ROWS_PER_TASK = 256;
+
+	// runs a task of the emit pool; its MatlabError* goes through the group
+	// by value, so the errors of the tasks after the first one, which the
+	// group drops, are freed with it
+	static void runEmitTask(const ThreadPool::TTask &task)
+	{
+		try
+		{
+			task();
+		}
+		catch (MatlabError *e)
+		{
+			MatlabError error(*e);
+			delete e;
+			throw error;
+		}
+	}
+
+	// waits for tasks run with runEmitTask, and throws their first error the
+	// way the rest of the translator does
+	static void waitEmitTasks(TaskGroup &group)
+	{
+		try
+		{
+			group.wait();
+		}
+		catch (MatlabError &e)
+		{
+			throw new MatlabError(e);
+		}
+	}
+
+	void PrintRowRange(TRow row, int begin, int end, vector<string> *rows, const char *stage, int *done)
+	{
+		int count = (int) rows->size();
+		for (int i = begin; i < end; i++)
+		{
+			(*rows)[i] = (this->*row)(i);
+			_monitor.advanceShared(stage, done, count);
+		}
+	}
+
+	// appends the given number of rows in order, printing blocks of them in
+	// parallel for large models
+	void appendRows(ostream &result, const char *stage, int count, TRow row)
+	{
+		int numTasks = 1;
+		if (_emitPool != NULL)
+			numTasks = min(count / MIN_ROWS_PER_TASK, (int) (_emitPool->size() + 1) * 4);
+		if (numTasks <= 1)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				result << (this->*row)(i);
+				_monitor.advance(stage, i + 1, count);
+			}
+			return;
+		}
+
+		vector<string> rows(count);
+		int done = 0;
+		TaskGroup group(*_emitPool);
+		for (int task = 0; task < numTasks; task++)
+		{
+			int begin = (int) ((long long) count * task / numTasks);
+			int end = (int) ((long long) count * (task + 1) / numTasks);
+			group.run(bind(&MatlabTranslator::runEmitTask,
+				ThreadPool::TTask(bind(&MatlabTranslator::PrintRowRange, this, row, begin, end, &rows, stage, &done))));
+		}
+		waitEmitTasks(group);
+		for (int i = 0; i < count; i++)
+		{
+			result << rows[i];
+		}
+	}
+
+	// prints a section on its own, for sections printed side by side; these
+	// never record value literals
+	void PrintSectionInto(TSection section, string *text)
+	{
+		stringstream result;
+		(this->*section)(result);
+		*text = result.str();
+	}
+
+	// prints a section straight to the output
+	void appendSection(ostream &result, TSection section)
+	{
+		_monitor.check();
+		(this->*section)(result);
+	}
+
+	// prints a value literal, and remembers where it went so it can be
+	// patched when the translation is kept
+	void recordValue(ostream &result, const string &id, double value)
+	{
+		if (!_bRecordSpans)
+		{
+			result << value;
+			return;
+		}
+		TValueSpan span;
+		span.id = id;
+		span.offset = (size_t) (result.tellp() - _spanOrigin);
+		result << value;
+		span.length = (size_t) (result.tellp() - _spanOrigin) - span.offset;
+		_valueSpans.push_back(span);
+	}
 
 
 	// deal with all strings, which could be: 
@@ -524,16 +1033,16 @@ private:
 
 					if (_bInlineMode)
 					{
-						replaceStream << _currentModel->globalParametersList[innerString];
+						replaceStream << lookupValue(_currentModel->globalParametersList, innerString);
 					}
 					else
 					{						
-						replaceStream << "rInfo.g_p" << _currentModel->globalParamIndexList[innerString];
+						replaceStream << "rInfo.g_p" << lookupValue(_currentModel->globalParamIndexList, innerString);
 					}
 
 					if (divideVolumes)
 					{
-						if (_currentModel->compartmentsList[_currentModel->sp_list[ib + _currentModel->numFloatingSpecies].compartment] != 1.0)
+						if (lookupValue(_currentModel->compartmentsList, _currentModel->sp_list[ib + _currentModel->numFloatingSpecies].compartment) != 1.0)
 							replaceStream << "/vol__" << _currentModel->sp_list[ib + _currentModel->numFloatingSpecies].compartment;
 
 						replaceStream << ")";
@@ -548,18 +1057,18 @@ private:
 
 				if (_bInlineMode)
 				{					
-					replaceStream << _currentModel->globalParametersList[innerString];
+					replaceStream << lookupValue(_currentModel->globalParametersList, innerString);
 				}
 				else
 				{
-					replaceStream << "rInfo.g_p" << _currentModel->globalParamIndexList[innerString];
+					replaceStream << "rInfo.g_p" << lookupValue(_currentModel->globalParamIndexList, innerString);
 				}
 
 			}
 		}
 		else if ( _currentModel->parameterMapList.find ( localParameterId ) != _currentModel->parameterMapList.end() )
 		{
-			replaceStream << _currentModel->parameterMapList[localParameterId];
+			replaceStream << lookupValue(_currentModel->parameterMapList, localParameterId);
 		}
 		else if ( _currentModel->compartmentsList.find ( innerString ) != _currentModel->compartmentsList.end() )
 		{
@@ -576,7 +1085,7 @@ private:
 				{
 
 					string compartment = "vol__" + _currentModel->sp_list[isp].compartment;
-					bool isUnitVolume = _currentModel->compartmentsList[_currentModel->sp_list[isp].compartment] == 1.0;
+					bool isUnitVolume = lookupValue(_currentModel->compartmentsList, _currentModel->sp_list[isp].compartment) == 1.0;
 					if (divideVolumes)
 						replaceStream << "(";
 
@@ -655,16 +1164,16 @@ private:
 
 					if (_bInlineMode)
 					{
-						replaceStream << _currentModel->globalParametersList[innerString];
+						replaceStream << lookupValue(_currentModel->globalParametersList, innerString);
 					}
 					else
 					{						
-						replaceStream << "rInfo.g_p" << _currentModel->globalParamIndexList[innerString];
+						replaceStream << "rInfo.g_p" << lookupValue(_currentModel->globalParamIndexList, innerString);
 					}
 
 					if (divideVolumes)
 					{
-						if (_currentModel->compartmentsList[_currentModel->sp_list[ib + _currentModel->numFloatingSpecies].compartment] != 1.0)
+						if (lookupValue(_currentModel->compartmentsList, _currentModel->sp_list[ib + _currentModel->numFloatingSpecies].compartment) != 1.0)
 							replaceStream << "/vol__" << _currentModel->sp_list[ib + _currentModel->numFloatingSpecies].compartment;
 
 						replaceStream << ")";
@@ -679,18 +1188,18 @@ private:
 
 				if (_bInlineMode)
 				{					
-					replaceStream << _currentModel->globalParametersList[innerString];
+					replaceStream << lookupValue(_currentModel->globalParametersList, innerString);
 				}
 				else
 				{
-					replaceStream << "rInfo.g_p" << _currentModel->globalParamIndexList[innerString];
+					replaceStream << "rInfo.g_p" << lookupValue(_currentModel->globalParamIndexList, innerString);
 				}
 
 			}
 		}
 		else if ( _currentModel->parameterMapList.find ( localParameterId ) != _currentModel->parameterMapList.end() )
 		{
-			replaceStream << _currentModel->parameterMapList[localParameterId];
+			replaceStream << lookupValue(_currentModel->parameterMapList, localParameterId);
 		}
 		else if ( _currentModel->compartmentsList.find ( innerString ) != _currentModel->compartmentsList.end() )
 		{
@@ -707,7 +1216,7 @@ private:
 				{
 
 					string compartment = "vol__" + _currentModel->sp_list[isp].compartment;
-					bool isUnitVolume = _currentModel->compartmentsList[_currentModel->sp_list[isp].compartment] == 1.0;
+					bool isUnitVolume = lookupValue(_currentModel->compartmentsList, _currentModel->sp_list[isp].compartment) == 1.0;
 					if (divideVolumes)
 						replaceStream << "(";
 
@@ -901,21 +1410,64 @@ private:
 public:
 	///
 	///MatlabTranslator Constructor
-	MatlabTranslator(bool bInline = false) 
+	///without a context the translator works in a private NOM context of its own,
+	///so translators on different threads never share NOM state
+	MatlabTranslator(bool bInline = false, const TranslationOptions* options = NULL, NOMContext* context = NULL) 
       : sbml()
-      , eqn()
       , stoich()
       , pname()
       , pvalue(0.0)
       , _currentModel(NULL)
+      , _nom(context)
+      , _bOwnsContext(context == NULL)
       , _bInlineMode(bInline)
+      , _options()
+      , _valueSpans()
+      , _bRecordSpans(false)
+      , _spanOrigin(0)
+      , _speciesReactions()
+      , _bMemoize(false)
+      , _symbols()
+      , _rateLawMemo()
+      , _ruleMemo()
+      , _stoichRowMemo()
+      , _emitPool(NULL)
+      , _monitor()
+	{
+		initTranslationOptions(&_options);
+		if (options != NULL)
+			_options = *options;
+		_monitor.setOptions(_options);
+		if (_bOwnsContext)
+			_nom = nom_context_create();
+	}
+
+	~MatlabTranslator()
+	{
+		delete _emitPool;
+		delete _currentModel;
+		if (_bOwnsContext)
+			nom_context_free(_nom);
+	}
+
+	// keeps the fragments printed for reactions, rules and stoichiometry rows
+	// between translations, so translating an edited model again only prints
+	// the elements that changed
+	void setMemoize(bool bMemoize)
 	{
+		_bMemoize = bMemoize;
+		if (!bMemoize)
+		{
+			_symbols.clear();
+			_rateLawMemo.clear();
+			_ruleMemo.clear();
+			_stoichRowMemo.clear();
+		}
 	}
 
 	// prints out the wrapper function for doing assignment and algebraic rules and solving the ode
-	string PrintWrapper()
+	void PrintWrapper(ostream &result)
 	{
-		stringstream result;
 		result << "function [t x rInfo] = " << _currentModel->modelName << "(tspan,solver,options)" << endl;
 		result << "    % initial conditions" << endl;
 		result << "    [x rInfo] = model();" << endl;
@@ -981,15 +1533,11 @@ public:
 		}
 
 		result << endl << "function [xdot rInfo] = model(time,x)" << endl;
-
-
-		return result.str();
 	}
 
 	/// prints the header information on how to use the matlab file
-	string PrintHeader()
+	void PrintHeader(ostream &result)
 	{
-		stringstream result; 
 		result <<  "%  How to use:" << endl;
 		result <<  "%" << endl;
 		result <<  "%  " << _currentModel->modelName << " takes 3 inputs and returns 3 outputs." << endl;
@@ -1021,54 +1569,42 @@ public:
 		result <<  "%     options = odeset('RelTol',1e-12,'AbsTol',1e-9);" << endl;
 		result <<  "%     [t x rInfo] = " << _currentModel->modelName << "(linspace(0,100,100),@ode23s,options);" << endl;
 		result <<  "%" << endl;
-
-		return result.str();
 	}
 
 	/// prints out the compartment information
-	string PrintOutCompartments()
+	void PrintOutCompartments(ostream &result)
 	{
-		stringstream result;
-
 		result << endl << "% List of Compartments " << endl;		
 
 		for(int i = 0; i < _currentModel->numCompartments; i++)
 		{
-			result << "vol__" << _currentModel->compartments[i].id 
-				<< " = " << _currentModel->compartments[i].value 
-				<< ";\t\t%"  << _currentModel->compartments[i].name << endl;
+			result << "vol__" << _currentModel->compartments[i].id << " = ";
+			recordValue(result, _currentModel->compartments[i].id, _currentModel->compartments[i].value);
+			result << ";\t\t%"  << _currentModel->compartments[i].name << endl;
 		}
-
-		return result.str();
 	}
 
 
 	// prints out the list of global parameters
-	string PrintOutGlobalParameters()
+	void PrintOutGlobalParameters(ostream &result)
 	{
-		stringstream result;		
-
 		if (_currentModel->numGlobalParameters > 0) {
 			result << endl << "% Global Parameters " << endl;
 		}
 		for(int i = 0; i < _currentModel->numGlobalParameters; i++)
 		{			
 
-			result <<  "rInfo.g_p" << (i+1) << " = " 
-				<< _currentModel->globalParameters[i].value << ";\t\t% " 
-				<< _currentModel->globalParameters[i].name << endl;
+			result <<  "rInfo.g_p" << (i+1) << " = ";
+			recordValue(result, _currentModel->globalParameters[i].name, _currentModel->globalParameters[i].value);
+			result << ";\t\t% " << _currentModel->globalParameters[i].name << endl;
 
 
 		}
-
-		return result.str();
 	}
 
 	// prints out the boundary species
-	string PrintOutBoundarySpecies()
+	void PrintOutBoundarySpecies(ostream &result)
 	{
-		stringstream result;
-
 		if (_currentModel->numBoundarySpecies > 0) 
 		{
 			result << endl << "% Boundary Conditions " << endl;
@@ -1092,21 +1628,19 @@ public:
 				value = _currentModel->sp_list[index].init_conc;				
 			}
 
-			result << value << ";\t\t% " << speciesId <<  " = " << _currentModel->sp_list[index].name 
+			recordValue(result, speciesId, value);
+			result << ";\t\t% " << speciesId <<  " = " << _currentModel->sp_list[index].name 
 				<< (isAmount ? " [Amount]" : "[Concentration]")  << endl;
 
 			_currentModel->globalParametersList[speciesId] = value;
 			_currentModel->globalParamIndexList[speciesId] = (_currentModel->numGlobalParameters + i + 1);
 		}
-
-		return result.str();
 	}
 
 
 	// prints out local parameters
-	string PrintLocalParameters()
+	void PrintLocalParameters(ostream &result)
 	{
-		stringstream result;
 		char buffer[100];
 		string strPvalue;
 		if (_currentModel->numReactions > 0) 
@@ -1158,14 +1692,11 @@ public:
 			}
 			_currentModel->nthReactionParameters[_currentModel->localParameterList] = i;
 		}
-
-		return result.str();
 	}
 
 	// prints an overview of floating species
-	string PrintSpeciesOverview()
+	void PrintSpeciesOverview(ostream &result)
 	{
-		stringstream result;
 		string floatingSpeciesName;
 		for(int i = 0; i < _currentModel->numFloatingSpecies; i++)
 		{			
@@ -1183,14 +1714,11 @@ public:
 			}
 		}
 		//result << endl << "xdot = zeros(" << _currentModel->numFloatingSpecies + numRateRules << ", 1);" << endl;
-
-		return result.str();
 	}
 
 	// prints out the initial conditions and reaction info
-	string PrintInitialConditions()
+	void PrintInitialConditions(ostream &result)
 	{
-		stringstream result;
 		char buffer[100];
 		// Print out Initial Conditions
 		string strPvalue;
@@ -1214,26 +1742,21 @@ public:
 			{
 				value = _currentModel->sp_list[i].init_amount;
 				bnd_data = " [Amount]";
-
-				sprintf( buffer, "%g", value );
-				strValue = buffer;
+				strValue = "";
 			}
 			else
 			{
 				value = _currentModel->sp_list[i].init_conc;
 				bnd_data = " [Concentration]";
-
-				sprintf( buffer, "%g", value );
-				strValue = buffer;
-
-				strValue = strValue + "*vol__" + _currentModel->sp_list[i].compartment;
+				strValue = "*vol__" + _currentModel->sp_list[i].compartment;
 			}
 
 			sprintf( buffer, "%d", i+1 );
 			strFloatingSpeciesIndex = buffer;
 
-			result <<  "   xdot(" << strFloatingSpeciesIndex << ") = " 
-				<<  strValue  <<  ";\t\t% " << floatingSpeciesName 
+			result <<  "   xdot(" << strFloatingSpeciesIndex << ") = ";
+			recordValue(result, floatingSpeciesName, value);
+			result <<  strValue  <<  ";\t\t% " << floatingSpeciesName 
 				<< " = " <<  _currentModel->sp_list[i].name << bnd_data << endl;
 			initCondIndex++;
 		}
@@ -1281,68 +1804,66 @@ public:
 			strValue = buffer;
 		}
 
-		result << PrintOutModel();
+		appendSection(result, &MatlabTranslator::PrintOutModel);
 
 
 
 		result << endl <<  "else" << endl;
-		return result.str();
 	}
 
-	string PrintOutModel()
+	// prints the row of the stoichiometry matrix of a floating species
+	string PrintStoichiometryRow(int i)
 	{
-		stringstream result;
 		char buffer[100];
-		// Printing out stoichiometry matrix
-		string strIndex;
-		result << endl << "   % reaction info structure";
-		result << endl << "   rInfo.stoich = [" << endl;
+		string eqn;
+		const vector<TSpeciesReaction> &speciesReactions = _speciesReactions[i];
 
-		for (int i = 0; i < _currentModel->numFloatingSpecies; i++)
+		// a row only depends on the non zero entries and the number of reactions
+		string source;
+		if (_bMemoize)
 		{
-			eqn = "     ";
-
-			string floatingSpeciesName;
-			floatingSpeciesName = _currentModel->sp_list[i].id;
-
-			for (int j = 0; j < _currentModel->numReactions; j++)
+			stringstream sourceStream;
+			sourceStream.precision(17);
+			sourceStream << _currentModel->numReactions;
+			for (size_t k = 0; k < speciesReactions.size(); k++)
 			{
-				int				numProducts = _currentModel->reactions[j].products.size();				
-				string			productName;
-				double			productStoichiometry = 0;
-				double			reactantStoichiometry = 0;
-
-				for(int k1 = 0; k1 < numProducts; k1++)
-				{
-					productName.clear();
-					productName = _currentModel->reactions[j].products[k1].name;
-
-					if (floatingSpeciesName == productName)
-					{
-						productStoichiometry = productStoichiometry + _currentModel->reactions[j].products[k1].value;
+				sourceStream << " " << speciesReactions[k].reaction
+					<< ":" << speciesReactions[k].productStoichiometry
+					<< ":" << speciesReactions[k].reactantStoichiometry;
+			}
+			source = sourceStream.str();
+			if (_stoichRowMemo.lookup(source, eqn))
+				return eqn + "\n";
+		}
 
-					}
-				}
+		eqn = "     ";
+		size_t next = 0;
+		for (int j = 0; j < _currentModel->numReactions; j++)
+		{
+			double			productStoichiometry = 0;
+			double			reactantStoichiometry = 0;
+			if (next < speciesReactions.size() && speciesReactions[next].reaction == j)
+			{
+				productStoichiometry = speciesReactions[next].productStoichiometry;
+				reactantStoichiometry = speciesReactions[next].reactantStoichiometry;
+				next++;
+			}
 
-				int				numReactants;
-				numReactants = _currentModel->reactions[j].reactants.size();
-				string			reactantName;
-				for(int k1 = 0; k1 < numReactants; k1++)
-				{
-					reactantName.clear();
-					reactantName = _currentModel->reactions[j].reactants[k1].name;
-					if (floatingSpeciesName == reactantName)
-					{
-						reactantStoichiometry = reactantStoichiometry + _currentModel->reactions[j].reactants[k1].value;
+			sprintf(buffer, "%g", productStoichiometry - reactantStoichiometry);
+			eqn      = eqn + " " + buffer;
+		}
+		if (_bMemoize)
+			_stoichRowMemo.store(source, eqn);
+		return eqn + "\n";
+	}
 
-					}
-				}
+	void PrintOutModel(ostream &result)
+	{
+		// Printing out stoichiometry matrix
+		result << endl << "   % reaction info structure";
+		result << endl << "   rInfo.stoich = [" << endl;
 
-				sprintf(buffer, "%g", productStoichiometry - reactantStoichiometry);
-				eqn      = eqn + " " + buffer;
-			}
-			result << eqn << endl;
-		}
+		appendRows(result, "printing stoichiometry", _currentModel->numFloatingSpecies, &MatlabTranslator::PrintStoichiometryRow);
 
 		result <<  "   ];" << endl;
 
@@ -1352,6 +1873,7 @@ public:
 
 		for (int i = 0; i < _currentModel->numFloatingSpecies; i++)
 		{
+			_monitor.check();
 
 			bool isAmount = _currentModel->sp_list[i].is_amount;
 			string speciesId = _currentModel->sp_list[i].id;
@@ -1371,7 +1893,8 @@ public:
 				valAmount = 0;
 			}
 
-			result << value << ", " << valAmount << endl;
+			recordValue(result, speciesId, value);
+			result << ", " << valAmount << endl;
 
 		}
 		result << "   };" << endl;
@@ -1381,9 +1904,9 @@ public:
 
 		for(int i = 0; i < _currentModel->numCompartments; i++)
 		{
-			result << "      '" << _currentModel->compartments[i].id 
-				<< "' , " << _currentModel->compartments[i].value
-				<< endl;
+			result << "      '" << _currentModel->compartments[i].id << "' , ";
+			recordValue(result, _currentModel->compartments[i].id, _currentModel->compartments[i].value);
+			result << endl;
 
 		}
 		result << "   };" << endl;
@@ -1396,7 +1919,8 @@ public:
 		{			
 
 			result <<  "      '" << _currentModel->globalParameters[i].name << "' , ";
-			result << _currentModel->globalParameters[i].value << endl;
+			recordValue(result, _currentModel->globalParameters[i].name, _currentModel->globalParameters[i].value);
+			result << endl;
 
 		}
 		result << "   };" << endl;
@@ -1426,7 +1950,8 @@ public:
 				valAmount = 0;
 			}
 
-			result << value << ", " << valAmount << endl;
+			recordValue(result, speciesId, value);
+			result << ", " << valAmount << endl;
 		}
 		result << "   };" << endl;
 
@@ -1453,8 +1978,6 @@ public:
 			}
 		}
 		result << "   };" << endl;
-
-		return result.str();
 	}
 
 	void stringReplace(string & str, string & oldStr, string & newStr)
@@ -1478,10 +2001,8 @@ public:
 
 
 	// prints out the list of assignment rules
-	string PrintOutRules()
+	void PrintOutRules(ostream &result)
 	{
-		stringstream result;
-
 		if (_currentModel->numRules > 0)
 		{
 			result << endl << "    % listOfRules" << endl;
@@ -1490,6 +2011,12 @@ public:
 			{
 				string rule = _currentModel->rules[i];
 				int ruleType = _currentModel->ruleTypes[i];
+				string line;
+				if (_bMemoize && _ruleMemo.lookup(rule, line))
+				{
+					result << line;
+					continue;
+				}
 				// find equals sign ... split to get id translate id and combine ...
 				size_t index = rule.find("=");
 				string iCouldCareLess;
@@ -1507,20 +2034,19 @@ public:
 					//}
 					//else if ((ruleType != SBML_RATE_RULE) && (ruleType != SBML_ASSIGNMENT_RULE))
 					//{
-					result << "   " <<  variable.substr(0, variable.length()-1) << " = " << equation << endl;
+					line = "   " + variable.substr(0, variable.length()-1) + " = " + equation + "\n";
 					//}
 				}
+				if (_bMemoize)
+					_ruleMemo.store(rule, line);
+				result << line;
 			}
 		}
-
-		return result.str();
 	}
 
 	// prints out user defined functions
-	string PrintOutUserDefinedFunctions()
+	void PrintOutUserDefinedFunctions(ostream &result)
 	{
-		stringstream result;
-
 		if (_currentModel->numUserDefinedFunctions > 0) 
 		{
 			result << endl << "% listOfUserDefinedFunctions" << endl;
@@ -1542,14 +2068,11 @@ public:
 				result << endl;
 			}
 		}
-		return result.str();
 	}
 
 	// prints out the events (not yet implemented)
-	string PrintOutEvents()
+	void PrintOutEvents(ostream &result)
 	{
-		string tstr;		
-
 		// #####################
 		//int numEvents = SBMLSupport::getNumEvents();
 
@@ -1557,141 +2080,89 @@ public:
 		//{
 		//	//tstr = tstr + "    % test event condition" + NL;
 		//}
-
-		return tstr;
 	}
 
-	// prints the calculation of the rates of change
-	string PrintRatesOfChange()
+	// prints the rate of a reaction
+	string PrintRateOfChange(int i)
 	{
 		stringstream result;
+		string kineticLaw = _currentModel->reactions[i].rateLaw;
+		string reactionId = _currentModel->reactions[i].id;
 
-		result << endl <<  "    % calculate rates of change" << endl;
-
-		for(int i = 0; i < _currentModel->numReactions; i++)
+		string law;
+		if (!_bMemoize || !_rateLawMemo.lookup(reactionId + "\n" + kineticLaw, law))
 		{
-			string kineticLaw = _currentModel->reactions[i].rateLaw;
-			string reactionId = _currentModel->reactions[i].id;
-
-			result << "   R" << i << " = " + (subConstants (kineticLaw, reactionId)) << endl;
+			law = subConstants (kineticLaw, reactionId);
+			if (_bMemoize)
+				_rateLawMemo.store(reactionId + "\n" + kineticLaw, law);
 		}
 
+		result << "   R" << i << " = " + law << endl;
 		return result.str();
 	}
 
-
-	// prints out the reaction scheme
-	string PrintOutReactionScheme()
+	// prints the calculation of the rates of change
+	void PrintRatesOfChange(ostream &result)
 	{
-		stringstream result;
-		string strIndex;
-		char buffer[100];
-		result << endl << "   xdot = [" << endl;
-
-		string floatingSpeciesName;
-		int xdotIndex = 1;
-		for (int i = 0; i < _currentModel->numFloatingSpecies; i++)
-		{
-			eqn = "     ";
+		result << endl <<  "    % calculate rates of change" << endl;
 
-			floatingSpeciesName.clear();
-			floatingSpeciesName = _currentModel->sp_list[i].id;
+		appendRows(result, "printing rates of change", _currentModel->numReactions, &MatlabTranslator::PrintRateOfChange);
+	}
 
-			for (int j = 0; j < _currentModel->numReactions; j++)
-			{
-				int				numProducts = _currentModel->reactions[j].products.size();				
 
-				string			productName;
-				string			strStoichiometry;
-				for(int k1 = 0; k1 < numProducts; k1++)
-				{
-					productName.clear();
-					productName = _currentModel->reactions[j].products[k1].name;
+	// prints the rate of change of a floating species
+	string PrintReactionSchemeRow(int i)
+	{
+		string eqn = "     ";
+		string floatingSpeciesName = _currentModel->sp_list[i].id;
 
-					if (floatingSpeciesName == productName)
-					{
-						double			productStoichiometry;
-						productStoichiometry = _currentModel->reactions[j].products[k1].value;
+		const vector<TSpeciesReaction> &speciesReactions = _speciesReactions[i];
+		for (size_t k = 0; k < speciesReactions.size(); k++)
+		{
+			eqn += speciesReactions[k].terms;
+		}
 
-						if (productStoichiometry != 1)
-						{
-							sprintf(buffer, "%g", productStoichiometry);
-							strStoichiometry = buffer;
-							stoich			 = strStoichiometry + '*';
-						}
-						else
-						{
-							stoich   = "";
-						}
-						sprintf(buffer, "%d", j);
-						strIndex = buffer;
-						eqn      = eqn + " + " + stoich + "R" + strIndex;
-					}
-				}
+		if (eqn == "     ") // add a rate rule reaction if defined for a floating species
+		{
+			for (int i = 0; i < _currentModel->numRules; i++)
+			{
 
-				int				numReactants;
-				numReactants = _currentModel->reactions[j].reactants.size();
-				string			reactantName;
-				for(int k1 = 0; k1 < numReactants; k1++)
+				string rule = _currentModel->rules[i];
+				int ruleType = _currentModel->ruleTypes[i];
+				if (ruleType == SBML_RATE_RULE)
 				{
-					reactantName.clear();
-					reactantName = _currentModel->reactions[j].reactants[k1].name;
-					if (floatingSpeciesName == reactantName)
+					// find equals sign ... split to get id translate id and combine ...
+					size_t index = rule.find("=");
+					string iCouldCareLess;
+					if (index != string::npos)
 					{
-						double			reactantStoichiometry;
-						reactantStoichiometry = _currentModel->reactions[j].reactants[k1].value;
-						if (reactantStoichiometry != 1)
-						{
-							sprintf(buffer, "%g", reactantStoichiometry);
-							strStoichiometry = buffer;
-							stoich			 = strStoichiometry + "*";
-						}
-						else
+						string variable = rule.substr(0, index - 1);
+						//variable = subConstants(variable, iCouldCareLess, false);
+						string equation = rule.substr(index + 1);
+						equation = subConstants(equation, iCouldCareLess);
+						if (floatingSpeciesName == variable)
 						{
-							stoich   = "";
+							eqn = eqn + equation + "\t\t% From rate rule";
 						}
-						sprintf(buffer, "%d", j);
-						strIndex = buffer;
-						eqn      = eqn + " - " + stoich + "R" + strIndex;
 					}
 				}
 			}
+		}
+		if (eqn == "     ") 
+		{
+			eqn =  eqn + "   0";
+		}
 
-			if (eqn == "     ") // add a rate rule reaction if defined for a floating species
-			{
-				for (int i = 0; i < _currentModel->numRules; i++)
-				{
-
-					string rule = _currentModel->rules[i];
-					int ruleType = _currentModel->ruleTypes[i];
-					if (ruleType == SBML_RATE_RULE)
-					{
-						// find equals sign ... split to get id translate id and combine ...
-						size_t index = rule.find("=");
-						string iCouldCareLess;
-						if (index != string::npos)
-						{
-							string variable = rule.substr(0, index - 1);
-							//variable = subConstants(variable, iCouldCareLess, false);
-							string equation = rule.substr(index + 1);
-							equation = subConstants(equation, iCouldCareLess);
-							if (floatingSpeciesName == variable)
-							{
-								eqn = eqn + equation + "\t\t% From rate rule";
-							}
-						}
-					}
-				}
-			}
-			if (eqn == "     ") 
-			{
-				eqn =  eqn + "   0";
-			}
+		return eqn + "\n";
+	}
 
+	// prints out the reaction scheme
+	void PrintOutReactionScheme(ostream &result)
+	{
+		result << endl << "   xdot = [" << endl;
 
-			xdotIndex++;
-			result << eqn << endl;
-		}
+		appendRows(result, "printing reaction scheme", _currentModel->numFloatingSpecies, &MatlabTranslator::PrintReactionSchemeRow);
+		int xdotIndex = _currentModel->numFloatingSpecies + 1;
 
 		//// adding in reactions with parameters from rate rules
 		//xdotIndex++;
@@ -1796,7 +2267,109 @@ public:
 		result <<  "   ];" << endl;
 		result <<  "end;" << endl;
 		result << endl << endl;
-		return result.str();
+	}
+
+	// collects the reactions every floating species takes part in, so the
+	// stoichiometry and rate of change rows do not scan all reactions
+	void IndexSpeciesReactions()
+	{
+		char buffer[100];
+		map<string, int> speciesIndex;
+		for (int i = 0; i < _currentModel->numFloatingSpecies; i++)
+		{
+			speciesIndex.insert(make_pair(_currentModel->sp_list[i].id, i));
+		}
+
+		_speciesReactions.assign(_currentModel->numFloatingSpecies, vector<TSpeciesReaction>());
+		for (int j = 0; j < _currentModel->numReactions; j++)
+		{
+			sprintf(buffer, "%d", j);
+			string strIndex = buffer;
+
+			for (int side = 0; side < 2; side++)
+			{
+				const vector<TNameValue> &participants = (side == 0) ? _currentModel->reactions[j].products : _currentModel->reactions[j].reactants;
+				for (size_t k1 = 0; k1 < participants.size(); k1++)
+				{
+					map<string, int>::iterator species = speciesIndex.find(participants[k1].name);
+					if (species == speciesIndex.end())
+						continue;
+
+					vector<TSpeciesReaction> &speciesReactions = _speciesReactions[species->second];
+					if (speciesReactions.empty() || speciesReactions.back().reaction != j)
+					{
+						TSpeciesReaction entry;
+						entry.reaction = j;
+						entry.productStoichiometry = 0;
+						entry.reactantStoichiometry = 0;
+						speciesReactions.push_back(entry);
+					}
+
+					TSpeciesReaction &entry = speciesReactions.back();
+					double stoichiometry = participants[k1].value;
+					string strStoichiometry;
+					if (stoichiometry != 1)
+					{
+						sprintf(buffer, "%g", stoichiometry);
+						strStoichiometry = buffer;
+						strStoichiometry += "*";
+					}
+					if (side == 0)
+					{
+						entry.productStoichiometry += stoichiometry;
+						entry.terms += " + " + strStoichiometry + "R" + strIndex;
+					}
+					else
+					{
+						entry.reactantStoichiometry += stoichiometry;
+						entry.terms += " - " + strStoichiometry + "R" + strIndex;
+					}
+				}
+			}
+		}
+	}
+
+	// describes everything subConstants looks up, memoized rate laws and
+	// rules are only valid as long as this description stays the same
+	string DescribeSymbols()
+	{
+		stringstream symbols;
+		symbols.precision(17);
+		symbols << "inline " << _bInlineMode << endl;
+		for (map<string, int>::const_iterator it = _currentModel->globalParamIndexList.begin(); it != _currentModel->globalParamIndexList.end(); ++it)
+		{
+			symbols << "p " << it->first << " " << it->second;
+			if (_bInlineMode)
+				symbols << " " << _currentModel->globalParametersList[it->first];
+			symbols << endl;
+		}
+		for (map<string, string>::const_iterator it = _currentModel->parameterMapList.begin(); it != _currentModel->parameterMapList.end(); ++it)
+		{
+			symbols << "l " << it->first << " " << it->second << endl;
+		}
+		for (map<string, double>::const_iterator it = _currentModel->compartmentsList.begin(); it != _currentModel->compartmentsList.end(); ++it)
+		{
+			symbols << "c " << it->first << " " << (it->second == 1.0) << endl;
+		}
+		for (int i = 0; i < _currentModel->numFloatingSpecies + _currentModel->numBoundarySpecies; i++)
+		{
+			symbols << "s " << _currentModel->sp_list[i].id << " " << _currentModel->sp_list[i].compartment
+				<< " " << _currentModel->sp_list[i].boundary << endl;
+		}
+		return symbols.str();
+	}
+
+	// drops the memoized rate laws and rules once the symbols they were
+	// printed against change, e.g. when species are added or reordered
+	void CheckMemoizedSymbols()
+	{
+		string symbols = DescribeSymbols();
+		if (symbols != _symbols)
+		{
+			_rateLawMemo.clear();
+			_ruleMemo.clear();
+			_symbols.swap(symbols);
+		}
 	}
 
 	bool isFloatingSpecies (string item)
@@ -1813,11 +2386,9 @@ public:
 
 
 	// prints the list of supported functions
-	string PrintSupportedFunctions()
+	void PrintSupportedFunctions(ostream &result)
 	{
-		stringstream result;
-
-		result << PrintOutUserDefinedFunctions();
+		PrintOutUserDefinedFunctions(result);
 
 		result <<  "%listOfSupportedFunctions" << endl;
 
@@ -1937,79 +2508,385 @@ public:
 		result <<  "function z = root(a,b) " << endl;
 		result <<  "	z = a^(1/b); " << endl;
 		result <<  " " << endl;
+	}
 
+	// translates an SBML file, which may be compressed with gzip, bzip2 or
+	// zip; returns an empty string if the file cannot be read
+	string translate(const string &fileName, bool *bTranslated = NULL)
+	{
+		ifstream oFile;
+		TCompression compression;
+		if (!openInput(fileName, oFile, compression))
+			return "";
+
+		// without a cache the content is never needed as a string, so the
+		// file goes straight to the libSBML file reader
+		if (_options.cacheDirectory == NULL || *_options.cacheDirectory == '\0')
+		{
+			oFile.close();
+			return translateDocument(readSBMLDocumentFromFile(fileName.c_str()), bTranslated);
+		}
 
-		return result.str();
+		// the cache keys on the content, read it in one go with its line breaks;
+		// compressed files are keyed on their compressed bytes
+		string sbml;
+		oFile.seekg(0, ios::end);
+		streamoff size = oFile.tellg();
+		oFile.seekg(0, ios::beg);
+		if (size > 0)
+		{
+			sbml.resize((size_t) size);
+			oFile.read(&sbml[0], size);
+			sbml.resize((size_t) oFile.gcount());
+		}
+		oFile.close();
+		return translateCached(sbml.c_str(), sbml.length(), compression != COMPRESSION_NONE ? fileName.c_str() : NULL, bTranslated);
 	}
 
-	string translate(const string &fileName)
+	// translates an SBML file straight into the given stream; only with the
+	// on-disk cache, which stores whole translations, is the translation
+	// held in memory
+	void translateTo(const string &fileName, ostream &out, bool *bTranslated = NULL)
 	{
-		string sbml, buffer;
+		if (_options.cacheDirectory != NULL && *_options.cacheDirectory != '\0')
+		{
+			out << translate(fileName, bTranslated);
+			return;
+		}
+		ifstream oFile;
+		TCompression compression;
+		if (!openInput(fileName, oFile, compression))
+			return;
+		oFile.close();
+		translateDocumentTo(readSBMLDocumentFromFile(fileName.c_str()), out, bTranslated);
+	}
 
-		ifstream oFile (fileName.c_str());
-		if (oFile.is_open())
+	// opens an SBML file and tells its compression, false if it cannot be read
+	bool openInput(const string &fileName, ifstream &oFile, TCompression &compression)
+	{
+		oFile.open(fileName.c_str(), ios::in | ios::binary);
+		if (!oFile.is_open())
 		{
-			while (!oFile.eof()) 
-			{
-				getline(oFile, buffer);
-				sbml+=buffer;
-			}
-			oFile.close();
-		} else {
 			fprintf (stderr, "File could not be opened\n");
-            return "";
-			//exit (0);
+			return false;
+		}
+
+		unsigned char header[4];
+		oFile.read((char *) header, sizeof(header));
+		compression = detectCompression(header, (size_t) oFile.gcount());
+		oFile.clear();
+		return canReadCompressed(fileName, compression);
+	}
+
+	// translates the content of an SBML file that was read already, a
+	// compressed file is parsed from the file again; returns an empty string
+	// if a compressed file cannot be read
+	string translateFileContent(const string &fileName, const string &content, bool *bTranslated = NULL)
+	{
+		TCompression compression = detectCompression((const unsigned char *) content.data(), content.length());
+		if (!canReadCompressed(fileName, compression))
+			return "";
+		return translateCached(content.c_str(), content.length(), compression != COMPRESSION_NONE ? fileName.c_str() : NULL, bTranslated);
+	}
+
+	// translates a file that is mapped into memory; the mapping is what is
+	// hashed and parsed, only compressed files are read again by name, as
+	// libSBML inflates nothing but files; returns an empty string if a
+	// compressed file cannot be read
+	string translateMappedFile(const string &fileName, const MappedFile &file, bool *bTranslated = NULL)
+	{
+		TCompression compression = detectCompression((const unsigned char *) file.data(), file.size());
+		if (!canReadCompressed(fileName, compression))
+			return "";
+		return translateCached(file.data(), file.size(), compression != COMPRESSION_NONE ? fileName.c_str() : NULL,
+			bTranslated, &file, fileName.c_str());
+	}
+
+	// libSBML decompresses while it parses, so the decompressed model is
+	// never held in memory as a whole, but it has to support the format
+	bool canReadCompressed(const string &fileName, TCompression compression)
+	{
+		if (compression == COMPRESSION_NONE)
+			return true;
+		if (compression == COMPRESSION_BZIP2 ? !SBMLReader::hasBzip2() : !SBMLReader::hasZlib())
+		{
+			fprintf (stderr, "File is compressed, but libSBML was built without support for it\n");
+			return false;
+		}
+		if (!hasCompressionExtension(fileName, compression))
+		{
+			fprintf (stderr, "File is compressed, name it with a .gz, .bz2 or .zip extension matching its format\n");
+			return false;
+		}
+		return true;
+	}
+
+	// checks the parsed document as deep as the validation option asks for
+	bool isValid(SBMLDocument *oDoc)
+	{
+		switch (_options.validation)
+		{
+		case VALIDATE_NONE:
+			return true;
+		case VALIDATE_FULL:
+			if (_options.validationThreads != 1)
+				return nom_checkDocumentConsistencyParallel(_nom, oDoc, _options.validationThreads) != -1;
+			return nom_checkDocumentConsistency(_nom, oDoc) != -1;
+		case VALIDATE_XML:
+		default:
+			return nom_validateDocument(_nom, oDoc) != -1;
+		}
+	}
+
+	// turns an error message into a matlab comment block
+	static string commentError(string error)
+	{
+		size_t endline = error.find("\n");
+		while (endline != string::npos) {
+			error.insert(endline+1, "% ");
+			endline = error.find("\n", endline+1);
+		}
+		return "% " + error;
+	}
+
+	// describes the translator version and every option that changes the output
+	string describeOptions()
+	{
+		stringstream description;
+		description << "sbml2matlab " << SBML2MATLAB_VERSION
+			<< " libsbml " << getLibSBMLDottedVersion()
+			<< " inline " << _bInlineMode
+			<< " validation " << _options.validation;
+		return description.str();
+	}
+
+	// translates the given sbml string to a matlab string, going through the
+	// on-disk cache if one is configured
+	string translateSBML(const string &sbmlInput, bool *bTranslated = NULL)
+	{
+		return translateCached(sbmlInput.c_str(), sbmlInput.length(), NULL, bTranslated);
+	}
+
+	// translates the given sbml string straight into the given stream,
+	// unless the on-disk cache wants the translation as a whole
+	void translateSBMLTo(const char *sbmlInput, ostream &out, bool *bTranslated = NULL)
+	{
+		if (_options.cacheDirectory != NULL && *_options.cacheDirectory != '\0')
+		{
+			out << translateSBML(sbmlInput, bTranslated);
+			return;
+		}
+		translateDocumentTo(readSBMLDocument(sbmlInput), out, bTranslated);
+	}
+
+	// translates the content through the on-disk cache; on a miss the file
+	// it was read from is parsed instead if a file name is given, else the
+	// content; content mapped from a file is refused once the file no longer
+	// matches the mapping, its translation would be cached under the hash
+	// of other content
+	string translateCached(const char *sbmlInput, size_t length, const char *fileName, bool *bTranslated = NULL,
+		const MappedFile *mapping = NULL, const char *mappedName = NULL)
+	{
+		if (_options.cacheDirectory == NULL || *_options.cacheDirectory == '\0')
+		{
+			return translateSource(sbmlInput, length, fileName, bTranslated, mapping, mappedName);
+		}
+
+		TranslationCache *cache = TranslationCache::open(_options.cacheDirectory,
+			(unsigned long long) _options.cacheMaxMegabytes * 1024 * 1024);
+		if (cache == NULL)
+		{
+			return translateSource(sbmlInput, length, fileName, bTranslated, mapping, mappedName);
+		}
+
+		string key = TranslationCache::makeKey(sbmlInput, length, describeOptions());
+		string translation;
+		if (cache->lookup(key, translation))
+		{
+			if (bTranslated != NULL) *bTranslated = true;
+			return translation;
+		}
+
+		bool bSucceeded = false;
+		translation = translateSource(sbmlInput, length, fileName, &bSucceeded, mapping, mappedName);
+		if (bTranslated != NULL) *bTranslated = bSucceeded;
+		if (bSucceeded)
+		{
+			cache->store(key, translation);
 		}
-		return translateSBML(sbml);
+		return translation;
+	}
+
+	string translateSource(const char *sbmlInput, size_t length, const char *fileName, bool *bTranslated,
+		const MappedFile *mapping = NULL, const char *mappedName = NULL)
+	{
+		SBMLDocument *oDoc = fileName != NULL ? readSBMLDocumentFromFile(fileName) : readSBMLDocumentFromMemory(sbmlInput, length);
+		if (mapping != NULL && !mapping->isCurrent(mappedName))
+		{
+			delete oDoc;
+			throw new MatlabError("The file changed while it was being translated");
+		}
+		return translateDocument(oDoc, bTranslated);
 	}
 
 	// translates the given sbml string to a matlab string
-	string translateSBML(const string &sbmlInput)
+	string translateUncached(const string &sbmlInput, bool *bTranslated = NULL)
+	{
+		return translateDocument(readSBMLDocument(sbmlInput.c_str()), bTranslated);
+	}
+
+	// translates a parsed document to a matlab string, the NOM takes the
+	// document over
+	string translateDocument(SBMLDocument *oDoc, bool *bTranslated = NULL)
 	{
 		stringstream result;
-		char * outSbml = "";
-		string outSbml_str;
-		if (validate(sbmlInput.c_str())==-1)
+		translateDocumentTo(oDoc, result, bTranslated);
+		return result.str();
+	}
+
+	// translates a parsed document straight into the given stream, one
+	// section after the other, so the translation is never held in memory
+	// as a whole; a model that cannot be translated gets its error report
+	void translateDocumentTo(SBMLDocument *oDoc, ostream &result, bool *bTranslated = NULL)
+	{
+		// the document is parsed once and handed through every stage:
+		// validation, parameter promotion, time symbol rewriting and rule
+		// sorting all work in place before the NOM takes it over
+		if (!isValid(oDoc))
 		{
-          const char* errch = getError();
+          // keep the document in the NOM so its errors can be queried
+          nom_loadSBMLDocument(_nom, oDoc);
+          // a failed validation always leaves the libSBML errors behind, so
+          // the message is the malloc'ed concatenation of both parts
+          char* errch = (char *) nom_getError(_nom);
           string error(errch);
-          delete errch;
-          size_t endline = error.find("\n");
-          while (endline != string::npos) {
-            error.insert(endline+1, "% ");
-            endline = error.find("\n", endline+1);
-          }
-          error = "% " + error;
-          return error;
+          free(errch);
+          result << commentError(error);
+          return;
 		}
 
+		if (oDoc->getModel() == NULL)
+		{
+          nom_loadSBMLDocument(_nom, oDoc);
+          result << commentError("Translation failed: the SBML document does not contain a model");
+          return;
+		}
 
-		getParamPromotedSBML(sbmlInput.c_str(), &outSbml);
-		reorderRules(&outSbml);
-		outSbml_str = outSbml;
+
+		nom_promoteLocalParameters(_nom, oDoc);
+		nom_reorderDocumentRules(_nom, oDoc);
         delete _currentModel;
-		_currentModel = new SBMLInfo(outSbml_str);
-
-		result << PrintHeader();
-		result << PrintWrapper();
-		result << PrintSpeciesOverview();
-		result << PrintOutCompartments();
-		result << PrintOutGlobalParameters();
-		result << PrintOutBoundarySpecies();
-		//result << PrintLocalParameters(); a bug is caused in linux for BIOMD0000000006
-		result << PrintInitialConditions();
-		result << PrintOutRules();
-		result << PrintOutEvents();
-		result << PrintRatesOfChange();
-		result << PrintOutReactionScheme();
-		result << PrintSupportedFunctions();
+		_currentModel = NULL; // a cancelled reading leaves no model behind
+		_currentModel = new SBMLInfo(_nom, oDoc, &_monitor);
+
+		_valueSpans.clear();
+		if (_bRecordSpans)
+			_spanOrigin = result.tellp();
+		IndexSpeciesReactions();
+		if (_options.emitThreads != 1 && _emitPool == NULL)
+		{
+			// the calling thread takes part in the work as well
+			int numThreads = (_options.emitThreads > 0 ? _options.emitThreads : ThreadPool::processorCount()) - 1;
+			_emitPool = new ThreadPool(max(numThreads, 1));
+		}
 
-		//delete _currentModel;
+		appendSection(result, &MatlabTranslator::PrintHeader);
+		appendSection(result, &MatlabTranslator::PrintWrapper);
+		appendSection(result, &MatlabTranslator::PrintSpeciesOverview);
+		appendSection(result, &MatlabTranslator::PrintOutCompartments);
+		appendSection(result, &MatlabTranslator::PrintOutGlobalParameters);
+		appendSection(result, &MatlabTranslator::PrintOutBoundarySpecies);
+		if (_bMemoize)
+			CheckMemoizedSymbols();
+		//appendSection(result, &MatlabTranslator::PrintLocalParameters); a bug is caused in linux for BIOMD0000000006
+		if (_emitPool == NULL)
+		{
+			appendSection(result, &MatlabTranslator::PrintInitialConditions);
+			appendSection(result, &MatlabTranslator::PrintOutRules);
+			appendSection(result, &MatlabTranslator::PrintOutEvents);
+			appendSection(result, &MatlabTranslator::PrintRatesOfChange);
+			appendSection(result, &MatlabTranslator::PrintOutReactionScheme);
+			appendSection(result, &MatlabTranslator::PrintSupportedFunctions);
+		}
+		else
+		{
+			// from here on the model is only read; the initial conditions are
+			// the only section left that records values, they are printed on
+			// this thread while the sections after them are printed by the pool
+			TSection sections[] = {
+				&MatlabTranslator::PrintOutRules,
+				&MatlabTranslator::PrintOutEvents,
+				&MatlabTranslator::PrintRatesOfChange,
+				&MatlabTranslator::PrintOutReactionScheme,
+				&MatlabTranslator::PrintSupportedFunctions
+			};
+			const int numSections = sizeof(sections) / sizeof(sections[0]);
+			string texts[numSections];
+			TaskGroup group(*_emitPool);
+			for (int i = 0; i < numSections; i++)
+			{
+				group.run(bind(&MatlabTranslator::runEmitTask,
+					ThreadPool::TTask(bind(&MatlabTranslator::PrintSectionInto, this, sections[i], &texts[i]))));
+			}
+			appendSection(result, &MatlabTranslator::PrintInitialConditions);
+			waitEmitTasks(group);
+			for (int i = 0; i < numSections; i++)
+			{
+				result << texts[i];
+			}
+		}
 
-		return result.str();
+		if (_bMemoize)
+		{
+			_rateLawMemo.endTranslation();
+			_ruleMemo.endTranslation();
+			_stoichRowMemo.endTranslation();
+		}
+
+		//delete _currentModel;
+		if (bTranslated != NULL)
+			*bTranslated = true;
 	}
 
 
+	// translates the given sbml string into a translation whose values can
+	// be patched later, returns NULL if the model could not be translated
+	MatlabTranslation* createTranslation(const string &sbmlInput)
+	{
+		bool bTranslated = false;
+		_bRecordSpans = true;
+		string text = translateUncached(sbmlInput, &bTranslated);
+		_bRecordSpans = false;
+		if (!bTranslated)
+			return NULL;
+
+		MatlabTranslation* translation = new MatlabTranslation();
+		translation->text.swap(text);
+		translation->spans.swap(_valueSpans);
+		translation->bInline = _bInlineMode;
+
+		TPatchableValue value;
+		for (int i = 0; i < _currentModel->numCompartments; i++)
+		{
+			value.kind = VALUE_COMPARTMENT;
+			value.value = _currentModel->compartments[i].value;
+			translation->values[_currentModel->compartments[i].id] = value;
+		}
+		for (int i = 0; i < _currentModel->numGlobalParameters; i++)
+		{
+			value.kind = VALUE_GLOBAL_PARAMETER;
+			value.value = _currentModel->globalParameters[i].value;
+			translation->values[_currentModel->globalParameters[i].name] = value;
+		}
+		for (int i = 0; i < _currentModel->numFloatingSpecies + _currentModel->numBoundarySpecies; i++)
+		{
+			spAttributes& species = _currentModel->sp_list[i];
+			value.kind = species.boundary ? VALUE_BOUNDARY_SPECIES : VALUE_FLOATING_SPECIES;
+			value.value = species.is_amount ? species.init_amount : species.init_conc;
+			translation->values[species.id] = value;
+		}
+		return translation;
+	}
 
 	// This method provides the implementation of getStoichiometryMatrix method
 	/// Read input sbml string and construct a Stoichiometry Matrix.
@@ -2131,17 +3008,1018 @@ public:
 //const string MatlabTranslator::NL      = "\n";
 //#endif
 
-DLL_EXPORT int sbml2matlab(const char* sbmlInput, char** matlabOutput)
+DLL_EXPORT void initTranslationOptions(TranslationOptions* options)
 {
-	try
-	{
-		MatlabTranslator translator(false);
-		string translation = translator.translateSBML(sbmlInput);
-		*matlabOutput = (char *) malloc((translation.length()+1)*sizeof(char));
-		strcpy(*matlabOutput,(char *) translation.c_str());
-	}
-	catch (MatlabError *e)
-	{
+	options->validation = VALIDATE_XML;
+	options->validationThreads = 1;
+	options->emitThreads = 1;
+	options->cacheDirectory = NULL;
+	options->cacheMaxMegabytes = 0;
+	options->cancelFlag = NULL;
+	options->progress = NULL;
+	options->progressData = NULL;
+}
+
+// owns the NOM context of one thread of the C API
+class TThreadContext
+{
+public:
+	TThreadContext() : ctx(nom_context_create()) {}
+	~TThreadContext() { nom_context_free(ctx); }
+	NOMContext* ctx;
+};
+
+// the NOM context sbml2matlab, getMatlab and their error queries work in;
+// every calling thread has its own, so concurrent calls never share NOM
+// state while the queries still see the last model of their thread
+static NOMContext* callContext()
+{
+	static thread_local TThreadContext context;
+	return context.ctx;
+}
+
+// leaves the context as a translation of a model without SBML errors does,
+// so a translation served from the cache does not report the errors of the
+// model translated before it
+static void clearSbmlErrors(NOMContext* context)
+{
+	if (context == NULL)
+		return;
+	SBMLDocument* oDoc = new SBMLDocument();
+	oDoc->createModel();
+	nom_loadSBMLDocument(context, oDoc);
+}
+
+// translates into a malloc'ed string, going through the in-process cache
+// when it is enabled
+static char* translateToCString(const char* sbmlInput, const TranslationOptions* options, NOMContext* context, bool* bTranslated = NULL)
+{
+	MatlabTranslator translator(false, options, context);
+	TranslationMemoryCache& cache = TranslationMemoryCache::instance();
+	size_t length = strlen(sbmlInput);
+	string description;
+	if (cache.enabled())
+	{
+		description = translator.describeOptions();
+		shared_ptr<const string> cached = cache.lookup(sbmlInput, length, description);
+		if (cached)
+		{
+			clearSbmlErrors(context);
+			if (bTranslated != NULL) *bTranslated = true;
+			char* matlabOutput = (char *) malloc((cached->length()+1)*sizeof(char));
+			memcpy(matlabOutput, cached->c_str(), cached->length()+1);
+			return matlabOutput;
+		}
+	}
+
+	bool bSucceeded = false;
+	string translation = translator.translateSBML(string(sbmlInput, length), &bSucceeded);
+	if (bTranslated != NULL) *bTranslated = bSucceeded;
+	if (bSucceeded && cache.enabled())
+	{
+		if (description.empty()) description = translator.describeOptions();
+		cache.store(sbmlInput, length, description, translation);
+	}
+	char* matlabOutput = (char *) malloc((translation.length()+1)*sizeof(char));
+	strcpy(matlabOutput,(char *) translation.c_str());
+	return matlabOutput;
+}
+
+DLL_EXPORT void setTranslationMemoryCacheSize(unsigned long maxBytes)
+{
+	TranslationMemoryCache::instance().setMaxBytes(maxBytes);
+}
+
+DLL_EXPORT void clearTranslationMemoryCache()
+{
+	TranslationMemoryCache::instance().clear();
+}
+
+DLL_EXPORT void getTranslationMemoryCacheStats(unsigned long* hits, unsigned long* misses, unsigned long* bytes)
+{
+	size_t held = 0;
+	TranslationMemoryCache::instance().getStats(hits, misses, &held);
+	if (bytes != NULL) *bytes = (unsigned long) held;
+}
+
+DLL_EXPORT MatlabTranslation* createMatlabTranslation(const char* sbmlInput, const TranslationOptions* options)
+{
+	try
+	{
+		MatlabTranslator translator(false, options);
+		return translator.createTranslation(sbmlInput);
+	}
+	catch (MatlabError *e)
+	{
+		delete e;
+		return NULL;
+	}
+}
+
+DLL_EXPORT const char* getTranslationText(MatlabTranslation* translation)
+{
+	return translation->text.c_str();
+}
+
+DLL_EXPORT int updateTranslationValues(MatlabTranslation* translation, int numValues, const char** ids, const double* values)
+{
+	return translation->updateValues(numValues, ids, values);
+}
+
+DLL_EXPORT const char* getTranslationError(MatlabTranslation* translation)
+{
+	return translation->error.c_str();
+}
+
+DLL_EXPORT void freeMatlabTranslation(MatlabTranslation* translation)
+{
+	delete translation;
+}
+
+struct TranslationSession
+{
+	MatlabTranslator translator;
+
+	TranslationSession(const TranslationOptions* options)
+      : translator(false, options)
+	{
+		translator.setMemoize(true);
+	}
+};
+
+DLL_EXPORT TranslationSession* createTranslationSession(const TranslationOptions* options)
+{
+	return new TranslationSession(options);
+}
+
+DLL_EXPORT int translateInSession(TranslationSession* session, const char* sbmlInput, char** matlabOutput)
+{
+	try
+	{
+		string translation = session->translator.translateSBML(sbmlInput);
+		*matlabOutput = (char *) malloc((translation.length()+1)*sizeof(char));
+		strcpy(*matlabOutput,(char *) translation.c_str());
+	}
+	catch (MatlabError *e)
+	{
+		fprintf(stderr, "MatlabTranslator exception: %s\n", e->getMessage().c_str());
+		delete e;
+		return -1;
+	}
+	return 0;
+}
+
+DLL_EXPORT void freeTranslationSession(TranslationSession* session)
+{
+	delete session;
+}
+
+// the work shared by the threads translating an archive
+typedef struct {
+	const OmexArchive* archive;
+	const TranslationOptions* options;
+	vector<string> outputFiles;
+	atomic<size_t> next;
+	atomic<int> failures;
+} TArchiveJob;
+
+static void translateArchiveEntry(TArchiveJob* job, size_t i)
+{
+	const vector<OmexArchive::TEntry>& models = job->archive->models();
+	string content, error;
+	if (!job->archive->read(models[i], content, error))
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		job->failures++;
+		return;
+	}
+
+	// every translator owns its NOM context, so the models are
+	// translated in parallel
+	MatlabTranslator translator(false, job->options);
+	string translation;
+	bool bTranslated = false;
+	if (job->options != NULL && job->options->cacheDirectory != NULL && *job->options->cacheDirectory != '\0')
+	{
+		translation = translator.translateSBML(content, &bTranslated);
+	}
+	else
+	{
+		SBMLDocument* oDoc = readSBMLDocument(content.c_str());
+		string().swap(content);
+		translation = translator.translateDocument(oDoc, &bTranslated);
+	}
+
+	if (!bTranslated)
+	{
+		fprintf(stderr, "'%s' could not be translated, see %s\n", models[i].location.c_str(), job->outputFiles[i].c_str());
+		job->failures++;
+	}
+	ofstream out(job->outputFiles[i].c_str());
+	out << translation << endl;
+	if (!out)
+	{
+		fprintf(stderr, "Cannot write '%s'\n", job->outputFiles[i].c_str());
+		if (bTranslated)
+			job->failures++;
+	}
+}
+
+static void translateArchiveWorker(TArchiveJob* job)
+{
+	const vector<OmexArchive::TEntry>& models = job->archive->models();
+	for (size_t i = job->next++; i < models.size(); i = job->next++)
+	{
+		// nothing may escape the thread, a model that throws is a failure
+		try
+		{
+			translateArchiveEntry(job, i);
+		}
+		catch (MatlabError *e)
+		{
+			fprintf(stderr, "'%s': MatlabTranslator exception: %s\n", models[i].location.c_str(), e->getMessage().c_str());
+			job->failures++;
+			delete e;
+		}
+		catch (...)
+		{
+			fprintf(stderr, "'%s' could not be translated\n", models[i].location.c_str());
+			job->failures++;
+		}
+	}
+}
+
+// names the .m file of an archive entry or batch file after it, as a valid
+// MATLAB function name that no other entry or file of the run uses
+static string matlabFileName(const string& location, vector<string>& usedNames)
+{
+	string name = location.substr(location.find_last_of("/\\") + 1);
+	size_t extension = name.find('.');
+	if (extension != string::npos)
+		name.erase(extension);
+	for (size_t i = 0; i < name.length(); i++)
+	{
+		if (!isalnum((unsigned char) name[i]) && name[i] != '_')
+			name[i] = '_';
+	}
+	if (name.empty() || !isalpha((unsigned char) name[0]))
+		name = "model_" + name;
+
+	string unique = name;
+	for (int n = 2; find(usedNames.begin(), usedNames.end(), unique) != usedNames.end(); n++)
+	{
+		stringstream numbered;
+		numbered << name << "_" << n;
+		unique = numbered.str();
+	}
+	usedNames.push_back(unique);
+	return unique + ".m";
+}
+
+// translates every SBML model of a COMBINE/OMEX archive into its own .m file
+static int translateArchive(const char* archiveName, const char* outputDirectory, const TranslationOptions* options, int numThreads)
+{
+	string error;
+	OmexArchive* archive = OmexArchive::open(archiveName, error);
+	if (archive == NULL)
+	{
+		fprintf(stderr, "%s: %s\n", archiveName, error.c_str());
+		return -1;
+	}
+
+	TArchiveJob job;
+	job.archive = archive;
+	job.options = options;
+	job.next = 0;
+	job.failures = 0;
+
+	string directory = (outputDirectory == NULL || *outputDirectory == '\0') ? "." : outputDirectory;
+	vector<string> usedNames;
+	for (size_t i = 0; i < archive->models().size(); i++)
+	{
+		job.outputFiles.push_back(directory + "/" + matlabFileName(archive->models()[i].location, usedNames));
+	}
+
+	if (numThreads <= 0)
+		numThreads = (int) thread::hardware_concurrency();
+	if (numThreads > (int) archive->models().size())
+		numThreads = (int) archive->models().size();
+
+	vector<thread> workers;
+	for (int i = 1; i < numThreads; i++)
+	{
+		workers.push_back(thread(translateArchiveWorker, &job));
+	}
+	translateArchiveWorker(&job);
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+
+	delete archive;
+	return job.failures;
+}
+
+DLL_EXPORT int sbml2matlabArchive(const char* archiveName, const char* outputDirectory, const TranslationOptions* options, int numThreads)
+{
+	try
+	{
+		return translateArchive(archiveName, outputDirectory, options, numThreads);
+	}
+	catch (MatlabError *e)
+	{
+		fprintf(stderr, "MatlabTranslator exception: %s\n", e->getMessage().c_str());
+		return -1;
+	}
+}
+
+// files per translator a stage of a batch run may run ahead of the next
+static const int BATCH_QUEUE_DEPTH = 2;
+
+// the journal a batch run keeps in its output directory
+static const char* BATCH_JOURNAL_NAME = "sbml2matlab.journal";
+
+// a file of a batch run on its way from the reader to the translators
+typedef struct {
+	size_t index;
+	MappedFile* file; // NULL if it cannot be read
+	string error;
+} TBatchRead;
+
+// a translation of a batch run on its way to the writer
+typedef struct {
+	size_t index;
+	string hash; // of the input, for the journal
+	bool bStarted; // whether the translation was started, and so has to be journaled
+	bool bSkipped; // translated by an earlier run already
+	string translation;
+	string error;
+} TBatchWrite;
+
+// a batch run is a pipeline of three stages: one thread maps and prefetches
+// the upcoming files, the translators work on them, and one thread writes
+// the .m files behind them; the queues in between bound the memory in use
+typedef struct {
+	vector<TBatchInput> inputs; // largest first
+	vector<string> outputFiles;
+	vector<string> results; // the status line of every input
+	const TranslationOptions* options;
+	BoundedQueue<TBatchRead>* readQueue;
+	BoundedQueue<TBatchWrite>* writeQueue;
+	BatchJournal* journal; // NULL when not journaling
+	WorkerPool* workers; // NULL when translating in this process
+	atomic<int> runningTranslators;
+	int failures;
+} TBatchJob;
+
+static void readBatchInputs(TBatchJob* job)
+{
+	for (size_t i = 0; i < job->inputs.size(); i++)
+	{
+		TBatchRead item;
+		item.index = i;
+		item.file = MappedFile::open(job->inputs[i].fileName, item.error);
+		if (item.file != NULL)
+			item.file->prefetch();
+		job->readQueue->push(item);
+	}
+	job->readQueue->close();
+}
+
+// translates one file of a batch run, the output is filled in for the writer;
+// the content is used straight from the mapping and never copied
+static void translateBatchRead(TBatchJob* job, const TBatchRead& item, TBatchWrite& output)
+{
+	const string& inputFile = job->inputs[item.index].fileName;
+	if (item.file == NULL)
+		return;
+
+	if (job->journal != NULL)
+	{
+		TSha256 digest;
+		digest.update(item.file->data(), item.file->size());
+		output.hash = digest.hexDigest();
+		BatchJournal::TState state = job->journal->state(inputFile, output.hash);
+		if (state == BatchJournal::JOURNAL_DONE && ifstream(job->outputFiles[item.index].c_str()).good())
+		{
+			output.bSkipped = true;
+			return;
+		}
+		if (state == BatchJournal::JOURNAL_CRASHED)
+		{
+			// translating it again would most likely take this run down too
+			job->journal->quarantined(inputFile, output.hash);
+			output.error = "quarantined, it crashed earlier runs or their workers";
+			return;
+		}
+		job->journal->started(inputFile, output.hash);
+	}
+	output.bStarted = true;
+
+	if (job->workers != NULL)
+	{
+		string translation;
+		int status = job->workers->translate(inputFile, item.file->data(), item.file->size(), *job->options, translation);
+		if (status == SERVER_TRANSLATED || status == SERVER_NOT_TRANSLATED)
+		{
+			output.translation.swap(translation);
+			if (output.translation.empty())
+				output.error = "cannot be read";
+			else if (status == SERVER_NOT_TRANSLATED)
+				output.error = "could not be translated, see " + job->outputFiles[item.index];
+		}
+		else
+		{
+			output.error = translation;
+			if (job->journal != NULL && (status == SERVER_CRASHED || status == SERVER_TIMED_OUT))
+			{
+				// it took a worker down, the quarantine is its last record
+				job->journal->quarantined(inputFile, output.hash);
+				output.bStarted = false;
+			}
+		}
+		return;
+	}
+
+	bool bTranslated = false;
+	try
+	{
+		MatlabTranslator translator(false, job->options);
+		output.translation = translator.translateMappedFile(inputFile, *item.file, &bTranslated);
+		if (output.translation.empty())
+			output.error = "cannot be read";
+		else if (!bTranslated)
+			output.error = "could not be translated, see " + job->outputFiles[item.index];
+	}
+	catch (MatlabError *e)
+	{
+		output.error = e->getMessage();
+		delete e;
+	}
+}
+
+static void translateBatchInputs(TBatchJob* job)
+{
+	TBatchRead item;
+	while (job->readQueue->pop(item))
+	{
+		TBatchWrite output;
+		output.index = item.index;
+		output.bStarted = false;
+		output.bSkipped = false;
+		output.error = item.error;
+		try
+		{
+			translateBatchRead(job, item, output);
+		}
+		catch (...)
+		{
+			// nothing may escape the thread, that would end the process
+			output.translation.clear();
+			output.error = "unexpected error during translation";
+		}
+		delete item.file;
+
+		// recorded before the writer queue, so a crash only leaves the files
+		// being translated without a record of their return
+		if (job->journal != NULL && output.bStarted)
+			job->journal->completed(job->inputs[item.index].fileName, output.hash);
+		job->writeQueue->push(output);
+	}
+	if (--job->runningTranslators == 0)
+		job->writeQueue->close();
+}
+
+static void writeBatchOutputs(TBatchJob* job)
+{
+	TBatchWrite output;
+	while (job->writeQueue->pop(output))
+	{
+		const string& outputFile = job->outputFiles[output.index];
+		if (!output.translation.empty())
+		{
+			ofstream out(outputFile.c_str());
+			out << output.translation << endl;
+			if (!out && output.error.empty())
+				output.error = "cannot write " + outputFile;
+		}
+
+		const string& inputFile = job->inputs[output.index].fileName;
+		if (job->journal != NULL && output.bStarted)
+			job->journal->finished(inputFile, output.hash, output.error.empty());
+
+		if (output.bSkipped)
+		{
+			job->results[output.index] = "skipped " + inputFile + " -> " + outputFile;
+		}
+		else if (output.error.empty())
+		{
+			job->results[output.index] = "ok      " + inputFile + " -> " + outputFile;
+		}
+		else
+		{
+			job->results[output.index] = "failed  " + inputFile + ": " + output.error;
+			job->failures++;
+		}
+	}
+}
+
+// translates every SBML file of a directory or manifest into its own .m
+// file, the largest files first so the translators finish at about the same
+// time; the progress is journaled in the output directory, and a resumed
+// run skips the files translated before and the files that crashed runs;
+// given worker processes, there is one translator per worker
+static int translateBatchFiles(const string& source, const string& outputDirectory, const TranslationOptions* options, int numThreads, bool bResume, WorkerPool* workers)
+{
+	TBatchJob job;
+	string error;
+	if (!listBatchInputs(source, job.inputs, error))
+	{
+		fprintf(stderr, "%s: %s\n", source.c_str(), error.c_str());
+		return -1;
+	}
+	if (!makeDirectory(outputDirectory))
+	{
+		fprintf(stderr, "Output directory '%s' cannot be used\n", outputDirectory.c_str());
+		return -1;
+	}
+
+	string journalName = outputDirectory + "/" + BATCH_JOURNAL_NAME;
+	job.journal = BatchJournal::open(journalName, bResume, error);
+	if (job.journal == NULL)
+	{
+		fprintf(stderr, "%s: %s\n", journalName.c_str(), error.c_str());
+		return -1;
+	}
+
+	job.options = options;
+	job.workers = workers;
+	job.failures = 0;
+	job.results.resize(job.inputs.size());
+	vector<string> usedNames;
+	for (size_t i = 0; i < job.inputs.size(); i++)
+	{
+		job.outputFiles.push_back(outputDirectory + "/" + matlabFileName(job.inputs[i].fileName, usedNames));
+	}
+
+	if (workers != NULL)
+		numThreads = (int) workers->size();
+	if (numThreads <= 0)
+		numThreads = ThreadPool::processorCount();
+	if (numThreads > (int) job.inputs.size())
+		numThreads = max((int) job.inputs.size(), 1);
+
+	// every translator has a couple of files ready and a couple waiting to be written
+	BoundedQueue<TBatchRead> readQueue(BATCH_QUEUE_DEPTH * numThreads);
+	BoundedQueue<TBatchWrite> writeQueue(BATCH_QUEUE_DEPTH * numThreads);
+	job.readQueue = &readQueue;
+	job.writeQueue = &writeQueue;
+	job.runningTranslators = numThreads;
+
+	thread reader(readBatchInputs, &job);
+	vector<thread> translators;
+	for (int i = 0; i < numThreads; i++)
+	{
+		translators.push_back(thread(translateBatchInputs, &job));
+	}
+	writeBatchOutputs(&job);
+	reader.join();
+	for (size_t i = 0; i < translators.size(); i++)
+	{
+		translators[i].join();
+	}
+
+	for (size_t i = 0; i < job.results.size(); i++)
+	{
+		fprintf(stdout, "%s\n", job.results[i].c_str());
+	}
+	fprintf(stdout, "%d of %d files translated\n", (int) job.inputs.size() - job.failures, (int) job.inputs.size());
+	delete job.journal;
+	return job.failures;
+}
+
+// saves of a file closer together than this are taken for one
+static const int WATCH_QUIET_MS = 100;
+
+// a watched file with the translator that keeps its fragments warm
+typedef struct {
+	MatlabTranslator* translator;
+	string outputName; // the name of its translation, without the directory
+	string outputFile;
+} TWatchedFile;
+
+static void translateWatchedFile(const string& inputFile, TWatchedFile& watched)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	bool bTranslated = false;
+	string translation, error;
+	try
+	{
+		translation = watched.translator->translate(inputFile, &bTranslated);
+		if (translation.empty())
+			error = "cannot be read";
+		else if (!bTranslated)
+			error = "could not be translated, see " + watched.outputFile;
+	}
+	catch (MatlabError *e)
+	{
+		error = e->getMessage();
+		delete e;
+	}
+	if (!translation.empty())
+	{
+		ofstream out(watched.outputFile.c_str());
+		out << translation << endl;
+		if (!out && error.empty())
+			error = "cannot write " + watched.outputFile;
+	}
+
+	long long milliseconds = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+	if (error.empty())
+		fprintf(stdout, "ok      %s -> %s (%lld ms)\n", inputFile.c_str(), watched.outputFile.c_str(), milliseconds);
+	else
+		fprintf(stdout, "failed  %s: %s\n", inputFile.c_str(), error.c_str());
+	fflush(stdout);
+}
+
+// translates the SBML files of a directory, and each of them again whenever
+// it is saved, until the directory goes away; every file keeps a translator
+// remembering what it printed, so a save costs the printing of what changed
+static int watchDirectory(const string& directory, const string& outputDirectory, const TranslationOptions* options)
+{
+	if (!makeDirectory(outputDirectory))
+	{
+		fprintf(stderr, "Output directory '%s' cannot be used\n", outputDirectory.c_str());
+		return -1;
+	}
+	// watching starts before the first pass, so no save goes unnoticed
+	string error;
+	DirectoryWatcher* watcher = DirectoryWatcher::open(directory, error);
+	if (watcher == NULL)
+	{
+		fprintf(stderr, "%s: %s\n", directory.c_str(), error.c_str());
+		return -1;
+	}
+
+	vector<TBatchInput> inputs;
+	listBatchInputs(directory, inputs, error);
+	vector<string> changed;
+	for (size_t i = 0; i < inputs.size(); i++)
+	{
+		changed.push_back(inputs[i].fileName);
+	}
+
+	map<string, TWatchedFile> watchedFiles;
+	vector<string> usedNames, removed;
+	do
+	{
+		// a file that is gone lets go of its translator, and of its output
+		// name, which it gets back if it is saved again
+		for (size_t i = 0; i < removed.size(); i++)
+		{
+			map<string, TWatchedFile>::iterator watched = watchedFiles.find(removed[i]);
+			if (watched == watchedFiles.end())
+				continue;
+			const string& outputName = watched->second.outputName;
+			usedNames.erase(remove(usedNames.begin(), usedNames.end(), outputName.substr(0, outputName.length() - 2)), usedNames.end());
+			delete watched->second.translator;
+			watchedFiles.erase(watched);
+		}
+		for (size_t i = 0; i < changed.size(); i++)
+		{
+			TWatchedFile& watched = watchedFiles[changed[i]];
+			if (watched.translator == NULL)
+			{
+				watched.translator = new MatlabTranslator(false, options);
+				watched.translator->setMemoize(true);
+				watched.outputName = matlabFileName(changed[i], usedNames);
+				watched.outputFile = outputDirectory + "/" + watched.outputName;
+			}
+			translateWatchedFile(changed[i], watched);
+		}
+	}
+	while (watcher->wait(changed, removed, WATCH_QUIET_MS));
+
+	fprintf(stderr, "%s can no longer be watched\n", directory.c_str());
+	for (map<string, TWatchedFile>::iterator watched = watchedFiles.begin(); watched != watchedFiles.end(); ++watched)
+	{
+		delete watched->second.translator;
+	}
+	delete watcher;
+	return -1;
+}
+
+// translates one model of a batch, a model that cannot be translated gets
+// its error report as output instead
+// copies an error report into a malloc'ed string
+static char* errorReportCString(const string& message)
+{
+	string error = "% " + message;
+	char* report = (char *) malloc((error.length()+1)*sizeof(char));
+	if (report != NULL)
+		strcpy(report, error.c_str());
+	return report;
+}
+
+static void translateBatchItem(const char* sbmlInput, char** matlabOutput, int* status)
+{
+	// the pool swallows what escapes a job, so the slots are filled first
+	*matlabOutput = NULL;
+	*status = -1;
+	bool bTranslated = false;
+	try
+	{
+		*matlabOutput = translateToCString(sbmlInput, NULL, NULL, &bTranslated);
+	}
+	catch (MatlabError *e)
+	{
+		*matlabOutput = errorReportCString(e->getMessage());
+		delete e;
+	}
+	catch (...)
+	{
+		*matlabOutput = errorReportCString("Translation failed with an unexpected error");
+	}
+	*status = bTranslated ? 0 : -1;
+}
+
+DLL_EXPORT int sbml2matlab_batch(const char** inputs, size_t n, char** outputs, int* status, int nthreads)
+{
+	if (n == 0)
+		return 0;
+	if (nthreads <= 0)
+		nthreads = ThreadPool::processorCount();
+	if ((size_t) nthreads > n)
+		nthreads = (int) n;
+
+	{
+		// every translator works in a NOM context of its own
+		ThreadPool pool(nthreads);
+		for (size_t i = 0; i < n; i++)
+		{
+			pool.submit(bind(translateBatchItem, inputs[i], &outputs[i], &status[i]));
+		}
+		pool.wait();
+	}
+
+	int failures = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		if (status[i] != 0)
+			failures++;
+	}
+	return failures;
+}
+
+// a translation running on the executor, shared by the job and the caller
+// holding the ticket, whichever lets go of it last frees it
+struct TranslationTicket
+{
+	string sbml;
+	string cacheDirectory;
+	TranslationOptions options;
+	TranslationCallback callback;
+	void* userData;
+
+	mutex lock;
+	condition_variable finished;
+	bool bDone;
+	int status;
+	string output;
+	string errorReport;
+
+	atomic<int> references;
+};
+
+static void releaseTicket(TranslationTicket* ticket)
+{
+	if (--ticket->references == 0)
+		delete ticket;
+}
+
+// the threads asynchronous translations run on, one per processor
+static ThreadPool& translationExecutor()
+{
+	static ThreadPool executor(0);
+	return executor;
+}
+
+static void runTicket(TranslationTicket* ticket)
+{
+	bool bTranslated = false;
+	string translation;
+	try
+	{
+		MatlabTranslator translator(false, &ticket->options);
+		translation = translator.translateSBML(ticket->sbml, &bTranslated);
+	}
+	catch (MatlabError *e)
+	{
+		translation = "% " + e->getMessage();
+		delete e;
+	}
+	catch (...)
+	{
+		// the pool swallows what escapes a job, and the waiters would never
+		// wake up
+		bTranslated = false;
+		translation = "% Translation failed with an unexpected error";
+	}
+	string().swap(ticket->sbml);
+	if (bTranslated)
+		ticket->output.swap(translation);
+	else
+		ticket->errorReport.swap(translation);
+	ticket->status = bTranslated ? 0 : -1;
+
+	// waiters wake up before the callback runs, so a callback may wait on
+	// its own ticket; the reference of this job keeps the strings alive
+	{
+		lock_guard<mutex> lock(ticket->lock);
+		ticket->bDone = true;
+	}
+	ticket->finished.notify_all();
+	if (ticket->callback != NULL)
+	{
+		try
+		{
+			ticket->callback(ticket->status, bTranslated ? ticket->output.c_str() : NULL, ticket->errorReport.c_str(), ticket->userData);
+		}
+		catch (...)
+		{
+		}
+	}
+	releaseTicket(ticket);
+}
+
+DLL_EXPORT TranslationTicket* sbml2matlab_submit(const char* sbmlInput, const TranslationOptions* options, TranslationCallback callback, void* userData)
+{
+	TranslationTicket* ticket = new TranslationTicket();
+	ticket->sbml = sbmlInput;
+	initTranslationOptions(&ticket->options);
+	if (options != NULL)
+		ticket->options = *options;
+	if (ticket->options.cacheDirectory != NULL)
+	{
+		// the caller's string may be gone by the time the job runs
+		ticket->cacheDirectory = ticket->options.cacheDirectory;
+		ticket->options.cacheDirectory = ticket->cacheDirectory.c_str();
+	}
+	ticket->callback = callback;
+	ticket->userData = userData;
+	ticket->bDone = false;
+	ticket->status = -1;
+	ticket->references = 2;
+
+	translationExecutor().submit(bind(runTicket, ticket));
+	return ticket;
+}
+
+DLL_EXPORT int sbml2matlab_poll(TranslationTicket* ticket)
+{
+	lock_guard<mutex> lock(ticket->lock);
+	return ticket->bDone ? 1 : 0;
+}
+
+DLL_EXPORT int sbml2matlab_wait(TranslationTicket* ticket, const char** matlabOutput, const char** errorReport)
+{
+	unique_lock<mutex> lock(ticket->lock);
+	while (!ticket->bDone)
+	{
+		ticket->finished.wait(lock);
+	}
+	if (matlabOutput != NULL)
+		*matlabOutput = ticket->status == 0 ? ticket->output.c_str() : NULL;
+	if (errorReport != NULL)
+		*errorReport = ticket->errorReport.c_str();
+	return ticket->status;
+}
+
+DLL_EXPORT void sbml2matlab_release(TranslationTicket* ticket)
+{
+	if (ticket != NULL)
+		releaseTicket(ticket);
+}
+
+// hands what is printed into it to a write callback in chunks of at most
+// its buffer size, and counts it; without a callback it only counts
+class TChunkedOutput : public streambuf
+{
+public:
+	TChunkedOutput(MatlabWriteCallback write, void* userData, size_t chunkSize)
+      : _write(write)
+      , _userData(userData)
+      , _buffer(chunkSize > 0 ? chunkSize : DEFAULT_CHUNK_SIZE)
+      , _total(0)
+      , _bStopped(false)
+	{
+		setp(&_buffer[0], &_buffer[0] + _buffer.size());
+	}
+
+	size_t total() const { return _total; }
+	bool stopped() const { return _bStopped; }
+
+protected:
+	int_type overflow(int_type c)
+	{
+		passOn();
+		if (!traits_type::eq_int_type(c, traits_type::eof()))
+		{
+			*pptr() = traits_type::to_char_type(c);
+			pbump(1);
+		}
+		return traits_type::not_eof(c);
+	}
+
+	int sync()
+	{
+		passOn();
+		return 0;
+	}
+
+private:
+	static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+	// a callback refusing a chunk stops the translation, the stream the
+	// translation prints to has to let the exception through
+	void passOn()
+	{
+		size_t length = (size_t) (pptr() - pbase());
+		_total += length;
+		if (_write != NULL && length > 0 && _write(pbase(), length, _userData) != 0)
+		{
+			_bStopped = true;
+			throw new MatlabError("The translation was stopped by its write callback");
+		}
+		setp(&_buffer[0], &_buffer[0] + _buffer.size());
+	}
+
+	MatlabWriteCallback _write;
+	void* _userData;
+	vector<char> _buffer;
+	size_t _total;
+	bool _bStopped;
+};
+
+DLL_EXPORT int sbml2matlab_stream(const char* sbmlInput, const TranslationOptions* options,
+	MatlabWriteCallback write, void* userData, size_t chunkSize, size_t* totalSize)
+{
+	TChunkedOutput sink(write, userData, chunkSize);
+	ostream out(&sink);
+	out.exceptions(ios::badbit);
+	int status;
+	try
+	{
+		bool bTranslated = false;
+		MatlabTranslator translator(false, options);
+		translator.translateSBMLTo(sbmlInput, out, &bTranslated);
+		out.flush();
+		status = bTranslated ? 0 : -1;
+	}
+	catch (MatlabError *e)
+	{
+		if (!sink.stopped())
+			fprintf(stderr, "MatlabTranslator exception: %s\n", e->getMessage().c_str());
+		status = sink.stopped() ? -2 : -1;
+		delete e;
+	}
+	if (totalSize != NULL)
+		*totalSize = sink.total();
+	return status;
+}
+
+DLL_EXPORT int sbml2matlabFile(const char* fileName, char** matlabOutput, const TranslationOptions* options)
+{
+	try
+	{
+		MatlabTranslator translator(false, options, callContext());
+		string translation = translator.translate(fileName);
+		if (translation.empty())
+			return -1;
+		*matlabOutput = (char *) malloc((translation.length()+1)*sizeof(char));
+		strcpy(*matlabOutput,(char *) translation.c_str());
+	}
+	catch (MatlabError *e)
+	{
+		fprintf(stderr, "MatlabTranslator exception: %s\n", e->getMessage().c_str());
+		return -1;
+	}
+	return 0;
+}
+
+DLL_EXPORT int sbml2matlab(const char* sbmlInput, char** matlabOutput)
+{
+	return sbml2matlabWithOptions(sbmlInput, matlabOutput, NULL);
+}
+
+DLL_EXPORT int sbml2matlabWithOptions(const char* sbmlInput, char** matlabOutput, const TranslationOptions* options)
+{
+	try
+	{
+		*matlabOutput = translateToCString(sbmlInput, options, callContext());
+	}
+	catch (MatlabError *e)
+	{
 		fprintf(stderr, "MatlabTranslator exception: %s\n", e->getMessage().c_str());
 		return -1;
 	}
@@ -2155,34 +4033,35 @@ DLL_EXPORT void freeMatlabString(char* matlabInput)
 
 DLL_EXPORT const char *getNomErrors()
 {
-	return getError();
+	return nom_getError(callContext());
 }
 
 DLL_EXPORT int getNumSbmlErrors()
 {
-	return getNumErrors();
+	return nom_getNumErrors(callContext());
 }
 
 DLL_EXPORT int getNthSbmlError (int index, int *line, int *column, int *errorId, char **errorType, char **errorMsg)
 {
-	return getNthError(index, line, column, errorId, errorType, errorMsg);
+	return nom_getNthError(callContext(), index, line, column, errorId, errorType, errorMsg);
 }
 
 DLL_EXPORT int validateSBMLString (const char *cSBML)
 {
 	//int test = validateSBML(cSBML);
-	return validateSBML(cSBML);
+	return nom_validateSBML(callContext(), cSBML);
 }
 
 DLL_EXPORT char* getMatlab(const char* sbmlInput)
+{
+  return getMatlabWithOptions(sbmlInput, NULL);
+}
+
+DLL_EXPORT char* getMatlabWithOptions(const char* sbmlInput, const TranslationOptions* options)
 {
   try
   {
-    MatlabTranslator translator(false);
-    string translation = translator.translateSBML(sbmlInput);
-    char* matlabOutput = (char *) malloc((translation.length()+1)*sizeof(char));
-    strcpy(matlabOutput,(char *) translation.c_str());
-    return matlabOutput;
+    return translateToCString(sbmlInput, options, callContext());
   }
   catch (MatlabError*)
   {
@@ -2190,6 +4069,152 @@ DLL_EXPORT char* getMatlab(const char* sbmlInput)
   }
 }
 
+// has a translation server translate, returns 0 if it answered, -1 if the
+// translation has to be done locally and -2 if it must not be
+static int translateOnServer(const string& socketPath, const string& sbml, const TranslationOptions& options, char** matlabOutput, bool bRequired)
+{
+	int status;
+	string matlab, error;
+	if (!requestTranslation(socketPath, sbml, options, status, matlab, error))
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		return bRequired ? -2 : -1;
+	}
+	// an untranslatable model gets its error report as output, as it does locally
+	const string& text = status == SERVER_TRANSLATED ? matlab : error;
+	*matlabOutput = (char *) malloc((text.length()+1)*sizeof(char));
+	strcpy(*matlabOutput, text.c_str());
+	return 0;
+}
+
+// what the worker processes of -workers run for every model
+static int translateInWorker(const string& fileName, const string& content, const TranslationOptions& options, string& output)
+{
+	bool bTranslated = false;
+	try
+	{
+		MatlabTranslator translator(false, &options);
+		output = translator.translateFileContent(fileName, content, &bTranslated);
+	}
+	catch (MatlabError *e)
+	{
+		output = "% " + e->getMessage();
+		delete e;
+	}
+	return bTranslated ? SERVER_TRANSLATED : SERVER_NOT_TRANSLATED;
+}
+
+// how the documents of a stream on stdin, and their translations on stdout,
+// are told apart
+enum TStreamFraming
+{
+	STREAM_NONE,   // stdin holds a single document
+	STREAM_NUL,    // every document ends with a NUL byte
+	STREAM_LENGTH  // every document follows its length as a 32 bit big endian number
+};
+
+// length framed documents larger than this are taken for a broken stream
+static const size_t STREAM_MAX_DOCUMENT_BYTES = 1024u * 1024u * 1024u;
+
+// length framed documents are read this much at a time, so memory only
+// grows with the bytes that actually arrive and not with the length claimed
+static const size_t STREAM_CHUNK_BYTES = 64 * 1024;
+
+// reads the next document of a stream, false at the end of the stream or
+// if it breaks off in the middle of, or announces too large, a length
+// framed document
+static bool readStreamDocument(istream& in, TStreamFraming framing, string& document, bool& bBroken)
+{
+	if (framing == STREAM_NUL)
+	{
+		if (!getline(in, document, '\0'))
+			return false;
+		// whitespace after the last NUL is not a document
+		return !in.eof() || document.find_first_not_of(" \t\r\n") != string::npos;
+	}
+
+	unsigned char header[4];
+	in.read((char*) header, sizeof(header));
+	if (in.gcount() == 0)
+		return false;
+	bBroken = in.gcount() != sizeof(header);
+	if (bBroken)
+		return false;
+	size_t length = ((size_t) header[0] << 24) | ((size_t) header[1] << 16) | ((size_t) header[2] << 8) | header[3];
+	bBroken = length > STREAM_MAX_DOCUMENT_BYTES;
+	document.clear();
+	while (!bBroken && document.length() < length)
+	{
+		size_t received = document.length();
+		size_t chunk = min(length - received, STREAM_CHUNK_BYTES);
+		document.resize(received + chunk);
+		in.read(&document[received], chunk);
+		bBroken = !in;
+	}
+	return !bBroken;
+}
+
+static void writeStreamDocument(ostream& out, TStreamFraming framing, const string& document)
+{
+	if (framing == STREAM_NUL)
+	{
+		out << document << '\0';
+	}
+	else
+	{
+		size_t length = document.length();
+		unsigned char header[4] = { (unsigned char) (length >> 24), (unsigned char) (length >> 16),
+			(unsigned char) (length >> 8), (unsigned char) length };
+		out.write((const char*) header, sizeof(header));
+		out << document;
+	}
+	// the producer may wait for this translation before it sends the next model
+	out.flush();
+}
+
+// translates a stream of documents on stdin into a stream of translations
+// on stdout in the same order and framing; one translator handles them all,
+// so the memory in use stays that of the largest model; a model that cannot
+// be translated gets its error report as translation
+static int translateStream(TStreamFraming framing, const TranslationOptions* options)
+{
+#ifdef WIN32
+	// the lengths and NULs have to pass through untouched
+	_setmode(_fileno(stdin), _O_BINARY);
+	_setmode(_fileno(stdout), _O_BINARY);
+#endif
+	MatlabTranslator translator(false, options);
+	string document, translation;
+	bool bBroken = false;
+	int failures = 0;
+	while (readStreamDocument(cin, framing, document, bBroken))
+	{
+		bool bTranslated = false;
+		try
+		{
+			translation = translator.translateSBML(document, &bTranslated);
+		}
+		catch (MatlabError *e)
+		{
+			translation = "% " + e->getMessage();
+			delete e;
+		}
+		if (!bTranslated)
+			failures++;
+		writeStreamDocument(cout, framing, translation);
+	}
+	if (bBroken)
+	{
+		fprintf(stderr, "The stream on stdin broke off in the middle of a document or announced one larger than %u MB\n",
+			(unsigned int) (STREAM_MAX_DOCUMENT_BYTES / (1024 * 1024)));
+		return -1;
+	}
+	return failures == 0 ? 0 : 1;
+}
+
+// seconds a worker process may spend on one model before it is taken for hung
+static const int DEFAULT_WORKER_TIMEOUT = 300;
+
 int main(int argc, char* argv[])
 {
 	bool doTranslate = false;
@@ -2200,6 +4225,25 @@ int main(int argc, char* argv[])
 	string infileName; 
 	string outfileName;
 	int success = 0;
+	int numThreads = 1;
+	string batchSource;
+	string batchOutputDirectory = ".";
+	bool bResume = false;
+	string serveSocket;
+	// scripts can be pointed at a running server without changing them
+	string clientSocket = getenv("SBML2MATLAB_SOCKET") != NULL ? getenv("SBML2MATLAB_SOCKET") : "";
+	bool bExplicitClient = false;
+	TStreamFraming streamFraming = STREAM_NONE;
+	string watchedDirectory;
+	bool bWorkers = false;
+	bool bWorkerTimeout = false;
+	int numWorkers = 0;
+	TWorkerLimits limits;
+	limits.wallSeconds = DEFAULT_WORKER_TIMEOUT;
+	limits.cpuSeconds = 0;
+	limits.memoryMegabytes = 0;
+	TranslationOptions options;
+	initTranslationOptions(&options);
     setlocale(LC_ALL,"C");
 
     for (int i = 1; i < argc; i++)
@@ -2218,12 +4262,132 @@ int main(int argc, char* argv[])
         doWriteToFile = true;
         i++;
       }
+      else if (current == "-validate" && i + 1 < argc)
+      {
+        string level(argv[i+1]);
+        if (level == "none")
+          options.validation = VALIDATE_NONE;
+        else if (level == "xml")
+          options.validation = VALIDATE_XML;
+        else if (level == "full")
+          options.validation = VALIDATE_FULL;
+        else {
+          fprintf (stderr, "Unknown validation level '%s', use none, xml or full\n", level.c_str());
+          return -1;
+        }
+        i++;
+      }
+      else if (current == "-validatethreads" && i + 1 < argc)
+      {
+        options.validationThreads = atoi(argv[i+1]);
+        i++;
+      }
+      else if (current == "-emitthreads" && i + 1 < argc)
+      {
+        options.emitThreads = atoi(argv[i+1]);
+        i++;
+      }
+      else if (current == "-cache" && i + 1 < argc)
+      {
+        options.cacheDirectory = argv[i+1];
+        i++;
+      }
+      else if (current == "-cachesize" && i + 1 < argc)
+      {
+        options.cacheMaxMegabytes = strtoul(argv[i+1], NULL, 10);
+        i++;
+      }
+      else if (current == "-batch" && i + 1 < argc)
+      {
+        stdinInput = false;
+        batchSource = argv[i+1];
+        i++;
+      }
+      else if (current == "--serve" && i + 1 < argc)
+      {
+        stdinInput = false;
+        serveSocket = argv[i+1];
+        i++;
+      }
+      else if (current == "--client" && i + 1 < argc)
+      {
+        clientSocket = argv[i+1];
+        bExplicitClient = true;
+        i++;
+      }
+      else if (current == "-watch" && i + 1 < argc)
+      {
+        stdinInput = false;
+        watchedDirectory = argv[i+1];
+        i++;
+      }
+      else if (current == "-resume")
+      {
+        bResume = true;
+      }
+      else if (current == "-outdir" && i + 1 < argc)
+      {
+        batchOutputDirectory = argv[i+1];
+        i++;
+      }
+      else if (current == "-stream" && i + 1 < argc)
+      {
+        string framing(argv[i+1]);
+        if (framing == "nul")
+          streamFraming = STREAM_NUL;
+        else if (framing == "length")
+          streamFraming = STREAM_LENGTH;
+        else {
+          fprintf (stderr, "Unknown stream framing '%s', use nul or length\n", framing.c_str());
+          return -1;
+        }
+        stdinInput = false;
+        i++;
+      }
+      else if (current == "-workers" && i + 1 < argc)
+      {
+        bWorkers = true;
+        numWorkers = atoi(argv[i+1]);
+        i++;
+      }
+      else if (current == "-workertimeout" && i + 1 < argc)
+      {
+        limits.wallSeconds = atoi(argv[i+1]);
+        bWorkerTimeout = true;
+        i++;
+      }
+      else if (current == "-cpulimit" && i + 1 < argc)
+      {
+        limits.cpuSeconds = atoi(argv[i+1]);
+        i++;
+      }
+      else if (current == "-memlimit" && i + 1 < argc)
+      {
+        limits.memoryMegabytes = strtoul(argv[i+1], NULL, 10);
+        i++;
+      }
+      else if (current == "-j" && i + 1 < argc)
+      {
+        numThreads = atoi(argv[i+1]);
+        i++;
+      }
       else if (current == "-h") {
         fprintf (stdout, "To translate an sbml file use: -input sbml.xml [-output output.m]\n");
+        fprintf (stdout, "To choose the validation done before translating use: -validate none|xml|full [-validatethreads N]\n");
+        fprintf (stdout, "To reuse translations across runs use: -cache directory [-cachesize megabytes]\n");
+        fprintf (stdout, "To print the equations of a large model on several threads use: -emitthreads N\n");
+        fprintf (stdout, "To translate every model of a COMBINE archive use: -input archive.omex [-output directory] [-j threads]\n");
+        fprintf (stdout, "To translate every SBML file of a directory or manifest use: -batch directory|manifest [-outdir directory] [-j threads] [-resume]\n");
+        fprintf (stdout, "To translate the SBML files of a directory again whenever they are saved use: -watch directory [-outdir directory]\n");
+        fprintf (stdout, "To keep translating requests of other sbml2matlab processes use: --serve socket\n");
+        fprintf (stdout, "To translate a stream of framed models on stdin into framed translations on stdout use: -stream nul|length\n");
+        fprintf (stdout, "To translate a batch or the requests of a server in worker processes use: -workers N [-workertimeout seconds]\n");
+        fprintf (stdout, "To abort the translations of a batch or server going over a limit use: -cpulimit seconds, -memlimit megabytes\n");
+        fprintf (stdout, "To have a server translate use: --client socket [-input sbml.xml] [-output output.m], or set SBML2MATLAB_SOCKET\n");
         stdinInput = false;
       }
       else if (current == "-v") {
-        fprintf (stdout, "sbml2matlab version 1.1.1\n");
+        fprintf (stdout, "sbml2matlab version %s\n", SBML2MATLAB_VERSION);
         stdinInput = false;
       }
       else if (i == 1) { // translate if sent as first param
@@ -2233,18 +4397,91 @@ int main(int argc, char* argv[])
       }
     }
 
+    // only a translation in a process of its own can be aborted, limits
+    // imply workers, as many as there would be translator threads; the
+    // default wall clock limit only applies to workers asked for
+    bool bLimits = limits.cpuSeconds > 0 || limits.memoryMegabytes > 0 || (bWorkerTimeout && limits.wallSeconds > 0);
+    if ((bWorkers || bLimits) && serveSocket.empty() && batchSource.empty())
+    {
+      fprintf (stderr, "-workers, -workertimeout, -cpulimit and -memlimit only apply to -batch and --serve\n");
+      return -1;
+    }
+    if (!bWorkers && bLimits)
+    {
+      bWorkers = true;
+      numWorkers = serveSocket.empty() ? numThreads : 0;
+    }
+
+    // the workers are forked before any thread is started
+    WorkerPool* workers = NULL;
+    if (bWorkers && (!serveSocket.empty() || !batchSource.empty()))
+    {
+      string error;
+      workers = WorkerPool::start(numWorkers, limits, translateInWorker, error);
+      if (workers == NULL)
+      {
+        fprintf (stderr, "Cannot start worker processes: %s\n", error.c_str());
+        return -1;
+      }
+    }
+
+    if (!serveSocket.empty())
+    {
+      return serveTranslations(serveSocket, workers, &options);
+    }
+
+    if (!watchedDirectory.empty())
+    {
+      return watchDirectory(watchedDirectory, batchOutputDirectory, &options);
+    }
+
+    if (streamFraming != STREAM_NONE)
+    {
+      return translateStream(streamFraming, &options);
+    }
+
     // Read input from command line
     if (stdinInput)
     {
-      stringstream sbmlStream;
-      string inputLine;
-      //while (getline(cin, inputLine))
-      while (cin)
+      // read everything in one go, keeping the line breaks for the error positions
+      string sbml((istreambuf_iterator<char>(cin)), istreambuf_iterator<char>());
+      int remote = clientSocket.empty() ? -1 : translateOnServer(clientSocket, sbml, options, &matlabOutput, bExplicitClient);
+      if (remote == -2)
+        return -1;
+      if (remote == -1)
+        success = sbml2matlabWithOptions(sbml.c_str(), &matlabOutput, &options);
+    }
+
+    // a batch turns every listed file into its own .m file, a summary line
+    // per file goes to stdout
+    if (!batchSource.empty())
+    {
+      int failures = translateBatchFiles(batchSource, batchOutputDirectory, &options, numThreads, bResume, workers);
+      delete workers;
+      return failures == 0 ? 0 : 1;
+    }
+
+    // a COMBINE archive turns into one .m file per model, -output names the directory
+    if (doTranslate && OmexArchive::isArchive(infileName))
+    {
+      int failures = translateArchive(infileName.c_str(), doWriteToFile ? outfileName.c_str() : ".", &options, numThreads);
+      return failures == 0 ? 0 : -1;
+    }
+
+    // plain SBML files can be handed to a server, compressed ones are
+    // parsed from the file by this process
+    if (doTranslate && !clientSocket.empty())
+    {
+      ifstream in(infileName.c_str(), ios::in | ios::binary);
+      string sbml((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+      if (in.is_open() && detectCompression((const unsigned char *) sbml.data(), sbml.length()) == COMPRESSION_NONE)
       {
-        getline(cin, inputLine);
-        sbmlStream << inputLine;
+        int remote = translateOnServer(clientSocket, sbml, options, &matlabOutput, bExplicitClient);
+        if (remote == -2)
+          return -1;
+        if (remote == 0)
+          doTranslate = false;
       }
-      success = sbml2matlab(sbmlStream.str().c_str(), &matlabOutput);
     }
 
     if (doWriteToFile) 
@@ -2255,8 +4492,9 @@ int main(int argc, char* argv[])
         return -1; 
       }
       if (doTranslate) {
-        MatlabTranslator translator(false);
-        out << translator.translate(infileName) << endl;
+        MatlabTranslator translator(false, &options, nom_default_context());
+        translator.translateTo(infileName, out);
+        out << endl;
         success = (getError() == NULL);
       }
       else {
@@ -2267,8 +4505,9 @@ int main(int argc, char* argv[])
     else //Write to stdout
     {
       if (doTranslate) {
-        MatlabTranslator translator(false);
-        cout << translator.translate(infileName) << endl;
+        MatlabTranslator translator(false, &options, nom_default_context());
+        translator.translateTo(infileName, cout);
+        cout << endl;
         success = (getError() == NULL);
       }
       else {
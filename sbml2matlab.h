@@ -32,6 +32,11 @@ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
 
+#ifndef SBML2MATLAB_H
+#define SBML2MATLAB_H
+
+#include <stddef.h>
+
 #ifdef WIN32
 #define DLL_EXPORT __declspec(dllexport)
 #else
@@ -40,6 +45,84 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
 
 extern "C"
 {
+	/** @brief Depth of the SBML validation done before translating
+	*/
+	enum ValidationLevel
+	{
+		VALIDATE_NONE = 0, /**< Trust the input and skip validation entirely */
+		VALIDATE_XML  = 1, /**< Only check the errors found while reading the XML (default) */
+		VALIDATE_FULL = 2  /**< Additionally run all libSBML consistency checks */
+	};
+
+	/** @brief Called as a translation works through the reactions and species of a model
+	*
+	* @param[in] stage What is being worked on, such as "reading reactions" or "printing rates of change"
+	* @param[in] done The number of items of the stage finished so far
+	* @param[in] total The number of items of the stage
+	* @param[in] userData The progressData of the translation options
+	*
+	* Reports come every few items and once a stage is complete. While rows are
+	* printed on several threads they come from those threads, one at a time.
+	*/
+	typedef void (*TranslationProgressCallback)(const char* stage, int done, int total, void* userData);
+
+	/** @brief Options controlling a translation
+	*
+	* Use initTranslationOptions to fill in the defaults before changing any field.
+	*/
+	typedef struct TranslationOptions
+	{
+		int validation; /**< One of the ValidationLevel values */
+		int validationThreads; /**< Threads for VALIDATE_FULL, each check category runs on its own thread. 1 (default) checks serially, 0 uses one per processor */
+		const char* cacheDirectory; /**< Directory of the on-disk translation cache, NULL (default) for no cache */
+		unsigned long cacheMaxMegabytes; /**< Size the cache directory is kept under by evicting the least recently used translations, 0 (default) for no limit */
+		int emitThreads; /**< Threads printing the rate laws, rows and sections of one model, the output is the same as the serial one. 1 (default) prints serially, 0 uses one per processor */
+		const volatile int* cancelFlag; /**< Checked for every reaction and species, once the flag is nonzero the translation is abandoned and fails. The flag has to outlive the translation. NULL (default) for no cancellation */
+		TranslationProgressCallback progress; /**< Told how far the translation has got, NULL (default) for no reports */
+		void* progressData; /**< Handed to the progress callback */
+	} TranslationOptions;
+
+	/** @brief A translation whose values can be updated without translating the model again
+	*/
+	typedef struct MatlabTranslation MatlabTranslation;
+
+	/** @brief A translator that remembers its output between translations of a changing model
+	*/
+	typedef struct TranslationSession TranslationSession;
+
+	/** @brief A translation submitted with sbml2matlab_submit
+	*/
+	typedef struct TranslationTicket TranslationTicket;
+
+	/** @brief Called on a worker thread when a submitted translation has finished
+	*
+	* @param[in] status 0 if the model was translated, -1 if not
+	* @param[in] matlabOutput The MATLAB function, NULL if the model could not be translated
+	* @param[in] errorReport Why the model could not be translated, empty if it was
+	* @param[in] userData The pointer given to sbml2matlab_submit
+	*
+	* Both strings stay valid until the callback returns or the ticket is
+	* released, whichever comes last. The ticket already counts as finished
+	* when the callback runs, so the callback may poll or wait on it.
+	*/
+	typedef void (*TranslationCallback)(int status, const char* matlabOutput, const char* errorReport, void* userData);
+
+	/** @brief Receives a chunk of the MATLAB text of sbml2matlab_stream
+	*
+	* @param[in] data The next bytes of the text, not NUL terminated and only valid during the call
+	* @param[in] length The number of bytes, at most the chunk size asked for
+	* @param[in] userData The pointer given to sbml2matlab_stream
+	*
+	* @return 0 to go on, anything else to stop the translation
+	*/
+	typedef int (*MatlabWriteCallback)(const char* data, size_t length, void* userData);
+
+	/** @brief Fills the options with the default values
+	*
+	* @param[out] options The options to initialize
+	*/
+	DLL_EXPORT void initTranslationOptions(TranslationOptions* options);
+
 	/** @brief translates SBML to the MATLAB function equivalent
 	*
 	* @param[in] sbmlInput The SBML string to be translated
@@ -49,6 +132,124 @@ extern "C"
 	*/
 	DLL_EXPORT int sbml2matlab(const char* sbmlInput, char** matlabOutput);
 
+	/** @brief translates SBML to the MATLAB function equivalent using the given options
+	*
+	* @param[in] sbmlInput The SBML string to be translated
+	* @param[in] matlabOutput Pointer to the C string to assign the translated MATLAB function
+	* @param[in] options The translation options, NULL for the defaults
+	*
+	* @return 0 if translation was successful, -1 if not
+	*/
+	DLL_EXPORT int sbml2matlabWithOptions(const char* sbmlInput, char** matlabOutput, const TranslationOptions* options);
+
+	/** @brief translates SBML and hands the MATLAB function over in chunks as it is printed
+	*
+	* The text is never held in one block: it is printed into a buffer of
+	* chunkSize bytes, which goes to the callback whenever it is full. A
+	* model that cannot be translated gets its error report as text, as with
+	* sbml2matlab. Without a callback the text is only counted, so a host can
+	* find out the size first and allocate once; the translation is the same
+	* both times.
+	*
+	* @param[in] sbmlInput The SBML string to be translated
+	* @param[in] options The translation options, NULL for the defaults
+	* @param[in] write Receives the text in chunks, NULL to only count it
+	* @param[in] userData Passed on to the callback
+	* @param[in] chunkSize The largest chunk handed to the callback, 0 for 64 KB
+	* @param[out] totalSize Receives the length of the text in bytes, without a terminating NUL, may be NULL
+	*
+	* @return 0 if translation was successful, -1 if not, -2 if the callback stopped it
+	*/
+	DLL_EXPORT int sbml2matlab_stream(const char* sbmlInput, const TranslationOptions* options,
+		MatlabWriteCallback write, void* userData, size_t chunkSize, size_t* totalSize);
+
+	/** @brief translates an SBML file to the MATLAB function equivalent
+	*
+	* Files compressed with gzip, bzip2 or zip are recognized by their content
+	* and decompressed while they are parsed, without temporary files. libSBML
+	* has to be built with compression support and the file name has to end in
+	* .gz, .bz2 or .zip accordingly.
+	*
+	* @param[in] fileName The name of the SBML file to be translated
+	* @param[in] matlabOutput Pointer to the C string to assign the translated MATLAB function
+	* @param[in] options The translation options, NULL for the defaults
+	*
+	* @return 0 if translation was successful, -1 if not
+	*/
+	DLL_EXPORT int sbml2matlabFile(const char* fileName, char** matlabOutput, const TranslationOptions* options);
+
+	/** @brief translates every SBML model of a COMBINE/OMEX archive
+	*
+	* The models listed in the manifest of the archive are read straight from
+	* the zip file without extracting them, and each is written to its own .m
+	* file named after the archive entry.
+	*
+	* @param[in] archiveName The name of the .omex file
+	* @param[in] outputDirectory The directory for the .m files, NULL for the current directory
+	* @param[in] options The translation options, NULL for the defaults
+	* @param[in] numThreads The number of models read and parsed at once, 0 for one per processor
+	*
+	* @return the number of models that could not be translated, -1 if the archive cannot be read
+	*/
+	DLL_EXPORT int sbml2matlabArchive(const char* archiveName, const char* outputDirectory, const TranslationOptions* options, int numThreads);
+
+	/** @brief Translates many SBML models at once on a pool of threads
+	*
+	* Idle threads take over models queued for busy ones, so a single large
+	* model does not hold up the rest. Every model is translated in its own NOM
+	* context, so the function can be called from several threads at once and
+	* leaves getNomErrors untouched. The in-process cache is used when enabled.
+	*
+	* @param[in] inputs The SBML strings to be translated
+	* @param[in] n The number of SBML strings
+	* @param[out] outputs Receives for every model its MATLAB function, or the error report if it could not be translated, NULL if memory ran out. Free each with freeMatlabString
+	* @param[out] status Receives for every model 0 if it was translated, -1 if not
+	* @param[in] nthreads The number of threads, 0 for one per processor
+	*
+	* @return the number of models that could not be translated
+	*/
+	DLL_EXPORT int sbml2matlab_batch(const char** inputs, size_t n, char** outputs, int* status, int nthreads);
+
+	/** @brief Starts translating SBML in the background and returns right away
+	*
+	* The translation runs on an internal pool of one thread per processor, in
+	* a NOM context of its own. The input and options are copied, so they can
+	* be freed as soon as the function returns.
+	*
+	* @param[in] sbmlInput The SBML string to be translated
+	* @param[in] options The translation options, NULL for the defaults
+	* @param[in] callback Called on the worker thread once the translation has finished, may be NULL
+	* @param[in] userData Passed on to the callback
+	*
+	* @return the ticket of the translation, free it with sbml2matlab_release
+	*/
+	DLL_EXPORT TranslationTicket* sbml2matlab_submit(const char* sbmlInput, const TranslationOptions* options, TranslationCallback callback, void* userData);
+	/** @brief Checks whether a submitted translation has finished, without blocking
+	*
+	* @param[in] ticket The ticket returned by sbml2matlab_submit
+	* @return 1 if the translation has finished, 0 if not; its callback may still be running
+	*/
+	DLL_EXPORT int sbml2matlab_poll(TranslationTicket* ticket);
+	/** @brief Waits for a submitted translation to finish
+	*
+	* Returns as soon as the translation has finished, its callback may still
+	* be running.
+	*
+	* @param[in] ticket The ticket returned by sbml2matlab_submit
+	* @param[out] matlabOutput Receives the MATLAB function, NULL if the model could not be translated, may be NULL. Valid until the ticket is released
+	* @param[out] errorReport Receives why the model could not be translated, may be NULL. Valid until the ticket is released
+	* @return 0 if the model was translated, -1 if not
+	*/
+	DLL_EXPORT int sbml2matlab_wait(TranslationTicket* ticket, const char** matlabOutput, const char** errorReport);
+	/** @brief Releases a ticket
+	*
+	* A translation that is still running is finished in the background, its
+	* callback is still called.
+	*
+	* @param[in] ticket The ticket returned by sbml2matlab_submit
+	*/
+	DLL_EXPORT void sbml2matlab_release(TranslationTicket* ticket);
+
 	/** @brief Frees MATLAB fumction string from memory
 	*
 	* @param[in] matlabInput The MATLAB string to be cleared from memory
@@ -58,6 +259,10 @@ extern "C"
 	
 	/** @brief Returns the error message from NOM 
 	*
+	* The error queries report on the last sbml2matlab, getMatlab or
+	* validateSBMLString call of the calling thread; calls on other threads
+	* do not affect them.
+	*
 	* @return char* to the error message
 	*/
 	DLL_EXPORT const char *getNomErrors();
@@ -95,4 +300,115 @@ extern "C"
 	*/
 	DLL_EXPORT char* getMatlab(const char* sbmlInput);
 
-}
\ No newline at end of file
+	/** @brief Translates SBML to the MATLAB function equivalent using the given options
+	*
+    * Takes @p sbmlInput as the SBML file, and returns Matlab.  Returns NULL
+    * on an error.
+	*
+	* @param[in] options The translation options, NULL for the defaults
+	* @return the Matlab translation if translation was successful, NULL if not.
+	*/
+	DLL_EXPORT char* getMatlabWithOptions(const char* sbmlInput, const TranslationOptions* options);
+
+	/** @brief Translates SBML into a translation handle whose values can be updated later
+	*
+	* Meant for parameter fitting, where only numbers change between runs.
+	*
+	* @param[in] sbmlInput The SBML string to be translated
+	* @param[in] options The translation options, NULL for the defaults
+	* @return the translation, or NULL if the model could not be translated. Free it with freeMatlabTranslation
+	*/
+	DLL_EXPORT MatlabTranslation* createMatlabTranslation(const char* sbmlInput, const TranslationOptions* options);
+
+	/** @brief Returns the MATLAB text of a translation
+	*
+	* @param[in] translation The translation
+	* @return the MATLAB text, valid until the translation is updated or freed
+	*/
+	DLL_EXPORT const char* getTranslationText(MatlabTranslation* translation);
+
+	/** @brief Patches new values of compartments, global parameters or species into a translation
+	*
+	* Only the numeric literals of the given values are rewritten, the model is
+	* not parsed again. Species values are in the unit they were given in the
+	* model, amount or concentration. Changes that would alter the equations are
+	* rejected and leave the translation untouched: unknown ids, compartment
+	* volumes changing to or from 1 and, in inline mode, global parameters and
+	* boundary species.
+	*
+	* @param[in] translation The translation to update
+	* @param[in] numValues The number of values
+	* @param[in] ids The ids of the elements to update
+	* @param[in] values The new values
+	* @return 0 if the translation was updated, -1 if not, see getTranslationError
+	*/
+	DLL_EXPORT int updateTranslationValues(MatlabTranslation* translation, int numValues, const char** ids, const double* values);
+
+	/** @brief Returns why the last update of a translation was rejected
+	*
+	* @param[in] translation The translation
+	* @return the error message, empty if the last update succeeded
+	*/
+	DLL_EXPORT const char* getTranslationError(MatlabTranslation* translation);
+
+	/** @brief Frees a translation
+	*
+	* @param[in] translation The translation to free
+	*/
+	DLL_EXPORT void freeMatlabTranslation(MatlabTranslation* translation);
+
+	/** @brief Creates a session for translating a model again and again as it is edited
+	*
+	* The session keeps the MATLAB printed for every reaction rate, rule and
+	* stoichiometry row. Translating an edited model only prints the elements
+	* that changed, plus everything that depends on a changed species,
+	* compartment or parameter list. A session must not be used by several
+	* threads at once.
+	*
+	* @param[in] options The translation options, NULL for the defaults
+	* @return the session, free it with freeTranslationSession
+	*/
+	DLL_EXPORT TranslationSession* createTranslationSession(const TranslationOptions* options);
+
+	/** @brief Translates SBML to the MATLAB function equivalent within a session
+	*
+	* @param[in] session The session
+	* @param[in] sbmlInput The SBML string to be translated
+	* @param[in] matlabOutput Pointer to the C string to assign the translated MATLAB function
+	*
+	* @return 0 if translation was successful, -1 if not
+	*/
+	DLL_EXPORT int translateInSession(TranslationSession* session, const char* sbmlInput, char** matlabOutput);
+
+	/** @brief Frees a session
+	*
+	* @param[in] session The session to free
+	*/
+	DLL_EXPORT void freeTranslationSession(TranslationSession* session);
+
+	/** @brief Sets the size of the in-process translation cache
+	*
+	* When enabled, sbml2matlab and getMatlab keep recent translations in memory
+	* and answer repeated requests for the same model and options from there.
+	* The least recently used translations are dropped to stay under the size.
+	* A translation answered from the cache leaves no SBML errors to query.
+	*
+	* @param[in] maxBytes The memory cap in bytes, 0 (default) disables the cache
+	*/
+	DLL_EXPORT void setTranslationMemoryCacheSize(unsigned long maxBytes);
+
+	/** @brief Drops all translations held by the in-process cache
+	*/
+	DLL_EXPORT void clearTranslationMemoryCache();
+
+	/** @brief Returns the statistics of the in-process translation cache
+	*
+	* @param[out] hits Number of requests answered from the cache, may be NULL
+	* @param[out] misses Number of requests that had to be translated, may be NULL
+	* @param[out] bytes Memory currently held by the cache, may be NULL
+	*/
+	DLL_EXPORT void getTranslationMemoryCacheStats(unsigned long* hits, unsigned long* misses, unsigned long* bytes);
+
+}
+
+#endif
@@ -0,0 +1,219 @@
+/* Filename    : testConsistency.cpp
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the University of Washington nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+
+// Checks that nom_checkDocumentConsistencyParallel leaves the same errors,
+// in the same order, as the serial nom_checkDocumentConsistency.
+
+#include "NOM.h"
+#include <iostream>
+#include <string>
+#include <sstream>
+
+using namespace std;
+
+#define SBML_HEADER "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" \
+	"<sbml xmlns=\"http://www.sbml.org/sbml/level2/version4\" level=\"2\" version=\"4\">\n"
+#define MATHML "<math xmlns=\"http://www.w3.org/1998/Math/MathML\">"
+
+// warnings from the units and the modeling practice checks only
+static const char* WARNINGS_MODEL = SBML_HEADER
+	"  <model id=\"warnings\">\n"
+	"    <listOfCompartments><compartment id=\"cell\" size=\"1\"/></listOfCompartments>\n"
+	"    <listOfSpecies>\n"
+	"      <species id=\"S1\" compartment=\"cell\" initialConcentration=\"10\"/>\n"
+	"      <species id=\"S2\" compartment=\"cell\" initialConcentration=\"0\"/>\n"
+	"    </listOfSpecies>\n"
+	"    <listOfParameters>\n"
+	"      <parameter id=\"k1\" value=\"0.1\"/>\n"
+	"      <parameter id=\"k2\"/>\n"
+	"    </listOfParameters>\n"
+	"    <listOfReactions>\n"
+	"      <reaction id=\"J1\" reversible=\"false\">\n"
+	"        <listOfReactants><speciesReference species=\"S1\"/></listOfReactants>\n"
+	"        <listOfProducts><speciesReference species=\"S2\"/></listOfProducts>\n"
+	"        <kineticLaw>" MATHML "<apply><plus/><apply><times/><ci>k1</ci><ci>S1</ci></apply><ci>k2</ci><cn>1</cn></apply></math></kineticLaw>\n"
+	"      </reaction>\n"
+	"    </listOfReactions>\n"
+	"  </model>\n"
+	"</sbml>\n";
+
+// a MathML error besides units and modeling practice warnings
+static const char* MATH_ERRORS_MODEL = SBML_HEADER
+	"  <model id=\"mathErrors\">\n"
+	"    <listOfCompartments><compartment id=\"cell\" size=\"1\"/></listOfCompartments>\n"
+	"    <listOfSpecies>\n"
+	"      <species id=\"S1\" compartment=\"cell\" initialConcentration=\"10\"/>\n"
+	"    </listOfSpecies>\n"
+	"    <listOfParameters>\n"
+	"      <parameter id=\"k1\" value=\"0.1\"/>\n"
+	"      <parameter id=\"k2\"/>\n"
+	"    </listOfParameters>\n"
+	"    <listOfReactions>\n"
+	"      <reaction id=\"J1\" reversible=\"false\">\n"
+	"        <listOfReactants><speciesReference species=\"S1\"/></listOfReactants>\n"
+	"        <kineticLaw>" MATHML "<apply><plus/><true/><apply><times/><ci>k1</ci><ci>S1</ci></apply></apply></math></kineticLaw>\n"
+	"      </reaction>\n"
+	"      <reaction id=\"J2\" reversible=\"false\">\n"
+	"        <listOfProducts><speciesReference species=\"S1\"/></listOfProducts>\n"
+	"        <kineticLaw>" MATHML "<apply><times/><ci>k2</ci><cn>2</cn></apply></math></kineticLaw>\n"
+	"      </reaction>\n"
+	"    </listOfReactions>\n"
+	"  </model>\n"
+	"</sbml>\n";
+
+// an identifier error, which stops the serial checks after their first category
+static const char* IDENTIFIER_ERRORS_MODEL = SBML_HEADER
+	"  <model id=\"identifierErrors\">\n"
+	"    <listOfCompartments><compartment id=\"cell\" size=\"1\"/></listOfCompartments>\n"
+	"    <listOfSpecies>\n"
+	"      <species id=\"S1\" compartment=\"cell\" initialConcentration=\"10\"/>\n"
+	"    </listOfSpecies>\n"
+	"    <listOfParameters>\n"
+	"      <parameter id=\"S1\" value=\"0.1\"/>\n"
+	"      <parameter id=\"k2\"/>\n"
+	"    </listOfParameters>\n"
+	"    <listOfReactions>\n"
+	"      <reaction id=\"J1\" reversible=\"false\">\n"
+	"        <listOfReactants><speciesReference species=\"S1\"/></listOfReactants>\n"
+	"        <kineticLaw>" MATHML "<apply><plus/><true/><ci>k2</ci></apply></math></kineticLaw>\n"
+	"      </reaction>\n"
+	"    </listOfReactions>\n"
+	"  </model>\n"
+	"</sbml>\n";
+
+// an error of the general SBML checks, later categories would find more
+static const char* GENERAL_ERRORS_MODEL = SBML_HEADER
+	"  <model id=\"generalErrors\">\n"
+	"    <listOfCompartments><compartment id=\"cell\" size=\"1\"/></listOfCompartments>\n"
+	"    <listOfSpecies>\n"
+	"      <species id=\"S1\" compartment=\"cell\" initialConcentration=\"10\"/>\n"
+	"    </listOfSpecies>\n"
+	"    <listOfParameters>\n"
+	"      <parameter id=\"k1\" value=\"0.1\"/>\n"
+	"      <parameter id=\"k2\"/>\n"
+	"    </listOfParameters>\n"
+	"    <listOfInitialAssignments>\n"
+	"      <initialAssignment symbol=\"k1\">" MATHML "<cn>1</cn></math></initialAssignment>\n"
+	"      <initialAssignment symbol=\"k1\">" MATHML "<cn>2</cn></math></initialAssignment>\n"
+	"    </listOfInitialAssignments>\n"
+	"    <listOfReactions>\n"
+	"      <reaction id=\"J1\" reversible=\"false\">\n"
+	"        <listOfReactants><speciesReference species=\"S1\"/></listOfReactants>\n"
+	"        <kineticLaw>" MATHML "<apply><plus/><false/><apply><times/><ci>k1</ci><ci>S1</ci><ci>k2</ci></apply></apply></math></kineticLaw>\n"
+	"      </reaction>\n"
+	"    </listOfReactions>\n"
+	"  </model>\n"
+	"</sbml>\n";
+
+static const char* VALID_MODEL = SBML_HEADER
+	"  <model id=\"valid\">\n"
+	"    <listOfCompartments><compartment id=\"cell\" size=\"1\"/></listOfCompartments>\n"
+	"  </model>\n"
+	"</sbml>\n";
+
+static int failures = 0;
+
+static void fail(const string& model, int numThreads, const string& what)
+{
+	cerr << model << ", " << numThreads << " threads: " << what << endl;
+	failures++;
+}
+
+static void compare(const char* name, const char* sbml, int numThreads)
+{
+	NOMContext* serialContext = nom_context_create();
+	NOMContext* parallelContext = nom_context_create();
+	SBMLDocument* serial = readSBMLDocument(sbml);
+	SBMLDocument* parallel = readSBMLDocument(sbml);
+
+	int serialResult = nom_checkDocumentConsistency(serialContext, serial);
+	int parallelResult = nom_checkDocumentConsistencyParallel(parallelContext, parallel, numThreads);
+
+	if (serialResult != parallelResult)
+	{
+		fail(name, numThreads, "the results differ");
+	}
+	if (string(nom_getError(serialContext)) != nom_getError(parallelContext))
+	{
+		fail(name, numThreads, "the error messages differ");
+	}
+	if (serial->getNumErrors() != parallel->getNumErrors())
+	{
+		fail(name, numThreads, "the number of errors differs");
+	}
+	else
+	{
+		for (unsigned int i = 0; i < serial->getNumErrors(); i++)
+		{
+			const SBMLError* expected = serial->getError(i);
+			const SBMLError* found = parallel->getError(i);
+			if (expected->getErrorId() != found->getErrorId()
+				|| expected->getSeverity() != found->getSeverity()
+				|| expected->getCategory() != found->getCategory()
+				|| expected->getLine() != found->getLine()
+				|| expected->getColumn() != found->getColumn()
+				|| expected->getMessage() != found->getMessage())
+			{
+				stringstream what;
+				what << "error " << i << " differs: " << expected->getMessage() << " / " << found->getMessage();
+				fail(name, numThreads, what.str());
+			}
+		}
+	}
+
+	delete serial;
+	delete parallel;
+	nom_context_free(serialContext);
+	nom_context_free(parallelContext);
+}
+
+int main()
+{
+	const char* names[] = { "warnings", "mathErrors", "identifierErrors", "generalErrors", "valid" };
+	const char* models[] = { WARNINGS_MODEL, MATH_ERRORS_MODEL, IDENTIFIER_ERRORS_MODEL, GENERAL_ERRORS_MODEL, VALID_MODEL };
+	const int threads[] = { 1, 2, 4, 0 };
+
+	for (size_t i = 0; i < sizeof(models) / sizeof(models[0]); i++)
+	{
+		for (size_t j = 0; j < sizeof(threads) / sizeof(threads[0]); j++)
+		{
+			compare(names[i], models[i], threads[j]);
+		}
+	}
+
+	// the models with errors must have errors to compare
+	SBMLDocument* document = readSBMLDocument(MATH_ERRORS_MODEL);
+	NOMContext* context = nom_context_create();
+	if (nom_checkDocumentConsistencyParallel(context, document, 4) != -1)
+	{
+		fail("mathErrors", 4, "the MathML error was not found");
+	}
+	delete document;
+	nom_context_free(context);
+
+	return failures == 0 ? 0 : 1;
+}
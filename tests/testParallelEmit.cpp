@@ -0,0 +1,159 @@
+/* Filename    : testParallelEmit.cpp
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the University of Washington nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+
+// Checks that translations printed by several threads are the same, byte for
+// byte, as the serial ones.
+
+#include "sbml2matlab.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+#define MATHML "<math xmlns=\"http://www.w3.org/1998/Math/MathML\">"
+
+// a chain of species long enough to split the stoichiometry, rate and
+// reaction scheme rows into blocks, with rules, events and functions for the
+// sections printed side by side
+static string chainModel(int length)
+{
+	stringstream sbml;
+	sbml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		<< "<sbml xmlns=\"http://www.sbml.org/sbml/level2/version4\" level=\"2\" version=\"4\">\n"
+		<< "  <model id=\"chain\">\n"
+		<< "    <listOfCompartments><compartment id=\"cell\" size=\"2\"/></listOfCompartments>\n"
+		<< "    <listOfSpecies>\n"
+		<< "      <species id=\"X0\" compartment=\"cell\" initialConcentration=\"10\" boundaryCondition=\"true\"/>\n";
+	for (int i = 1; i <= length; i++)
+	{
+		sbml << "      <species id=\"S" << i << "\" compartment=\"cell\" initialConcentration=\"" << (i % 7) * 0.5 << "\"/>\n";
+	}
+	sbml << "    </listOfSpecies>\n"
+		<< "    <listOfParameters>\n";
+	for (int i = 1; i <= length; i++)
+	{
+		sbml << "      <parameter id=\"k" << i << "\" value=\"" << 1.0 / i << "\"/>\n";
+	}
+	for (int i = 1; i <= length / 10; i++)
+	{
+		sbml << "      <parameter id=\"p" << i << "\" value=\"0\" constant=\"false\"/>\n";
+	}
+	sbml << "      <parameter id=\"q\" value=\"1\" constant=\"false\"/>\n"
+		<< "    </listOfParameters>\n"
+		<< "    <listOfRules>\n";
+	for (int i = 1; i <= length / 10; i++)
+	{
+		sbml << "      <assignmentRule variable=\"p" << i << "\">" MATHML
+			<< "<apply><times/><cn>2</cn><ci>S" << i * 10 << "</ci></apply></math></assignmentRule>\n";
+	}
+	sbml << "      <rateRule variable=\"q\">" MATHML "<apply><minus/><ci>q</ci></apply></math></rateRule>\n"
+		<< "    </listOfRules>\n"
+		<< "    <listOfReactions>\n";
+	for (int i = 1; i <= length; i++)
+	{
+		string reactant = (i == 1 ? "X0" : "S" + to_string(i - 1));
+		sbml << "      <reaction id=\"J" << i << "\" reversible=\"false\">\n"
+			<< "        <listOfReactants><speciesReference species=\"" << reactant << "\"/></listOfReactants>\n"
+			<< "        <listOfProducts><speciesReference species=\"S" << i << "\" stoichiometry=\"" << 1 + i % 3 << "\"/></listOfProducts>\n"
+			<< "        <kineticLaw>" MATHML;
+		if (i % 5 == 0)
+		{
+			sbml << "<apply><times/><ci>k" << i << "</ci><apply><power/><ci>" << reactant << "</ci><cn>2</cn></apply></apply>";
+		}
+		else if (i % 7 == 0)
+		{
+			sbml << "<piecewise><piece><apply><times/><ci>k" << i << "</ci><ci>" << reactant << "</ci></apply>"
+				<< "<apply><gt/><ci>" << reactant << "</ci><cn>1</cn></apply></piece><otherwise><cn>0</cn></otherwise></piecewise>";
+		}
+		else
+		{
+			sbml << "<apply><times/><ci>k" << i << "</ci><ci>" << reactant << "</ci></apply>";
+		}
+		sbml << "</math></kineticLaw>\n"
+			<< "      </reaction>\n";
+	}
+	sbml << "    </listOfReactions>\n"
+		<< "    <listOfEvents>\n";
+	for (int i = 1; i <= 3; i++)
+	{
+		sbml << "      <event id=\"E" << i << "\">\n"
+			<< "        <trigger>" MATHML "<apply><gt/><ci>S" << i << "</ci><cn>" << i << "</cn></apply></math></trigger>\n"
+			<< "        <listOfEventAssignments><eventAssignment variable=\"q\">" MATHML
+			<< "<cn>" << i << "</cn></math></eventAssignment></listOfEventAssignments>\n"
+			<< "      </event>\n";
+	}
+	sbml << "    </listOfEvents>\n"
+		<< "  </model>\n"
+		<< "</sbml>\n";
+	return sbml.str();
+}
+
+static string translate(const string& sbml, int emitThreads)
+{
+	TranslationOptions options;
+	initTranslationOptions(&options);
+	options.emitThreads = emitThreads;
+
+	char* matlab = NULL;
+	if (sbml2matlabWithOptions(sbml.c_str(), &matlab, &options) != 0)
+	{
+		return "";
+	}
+	string text(matlab);
+	freeMatlabString(matlab);
+	return text;
+}
+
+int main()
+{
+	int failures = 0;
+	const int lengths[] = { 10, 600, 2000 };
+	const int threads[] = { 2, 4, 0 };
+
+	for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+	{
+		string sbml = chainModel(lengths[i]);
+		string serial = translate(sbml, 1);
+		if (serial.empty())
+		{
+			cerr << lengths[i] << " species: the model could not be translated" << endl;
+			failures++;
+			continue;
+		}
+		for (size_t j = 0; j < sizeof(threads) / sizeof(threads[0]); j++)
+		{
+			if (translate(sbml, threads[j]) != serial)
+			{
+				cerr << lengths[i] << " species, " << threads[j] << " threads: the translation differs from the serial one" << endl;
+				failures++;
+			}
+		}
+	}
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+/* Filename    : testTranslationValues.cpp
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the University of Washington nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+
+// Checks that updateTranslationValues patches a translation into the text a
+// fresh translation of the changed model gives, and leaves rejected updates
+// untouched.
+
+#include "sbml2matlab.h"
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static string model(const char* volume, const char* k1, const char* s1, const char* x0)
+{
+	return string("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<sbml xmlns=\"http://www.sbml.org/sbml/level2/version4\" level=\"2\" version=\"4\">\n"
+		"  <model id=\"values\">\n"
+		"    <listOfCompartments><compartment id=\"cell\" size=\"") + volume + "\"/></listOfCompartments>\n"
+		"    <listOfSpecies>\n"
+		"      <species id=\"X0\" compartment=\"cell\" initialConcentration=\"" + x0 + "\" boundaryCondition=\"true\"/>\n"
+		"      <species id=\"S1\" compartment=\"cell\" initialConcentration=\"" + s1 + "\"/>\n"
+		"      <species id=\"S2\" compartment=\"cell\" initialAmount=\"0\"/>\n"
+		"    </listOfSpecies>\n"
+		"    <listOfParameters>\n"
+		"      <parameter id=\"k1\" value=\"" + k1 + "\"/>\n"
+		"      <parameter id=\"k2\" value=\"0.25\"/>\n"
+		"    </listOfParameters>\n"
+		"    <listOfReactions>\n"
+		"      <reaction id=\"J1\" reversible=\"false\">\n"
+		"        <listOfReactants><speciesReference species=\"X0\"/></listOfReactants>\n"
+		"        <listOfProducts><speciesReference species=\"S1\"/></listOfProducts>\n"
+		"        <kineticLaw><math xmlns=\"http://www.w3.org/1998/Math/MathML\">"
+		"<apply><times/><ci>k1</ci><ci>X0</ci></apply></math></kineticLaw>\n"
+		"      </reaction>\n"
+		"      <reaction id=\"J2\" reversible=\"false\">\n"
+		"        <listOfReactants><speciesReference species=\"S1\"/></listOfReactants>\n"
+		"        <listOfProducts><speciesReference species=\"S2\"/></listOfProducts>\n"
+		"        <kineticLaw><math xmlns=\"http://www.w3.org/1998/Math/MathML\">"
+		"<apply><times/><ci>k2</ci><ci>S1</ci></apply></math></kineticLaw>\n"
+		"      </reaction>\n"
+		"    </listOfReactions>\n"
+		"  </model>\n"
+		"</sbml>\n";
+}
+
+static int failures = 0;
+
+static void fail(const string& what)
+{
+	cerr << what << endl;
+	failures++;
+}
+
+static string translate(const string& sbml)
+{
+	char* matlab = NULL;
+	if (sbml2matlab(sbml.c_str(), &matlab) != 0)
+	{
+		fail("the model could not be translated");
+		return "";
+	}
+	string text(matlab);
+	freeMatlabString(matlab);
+	return text;
+}
+
+int main()
+{
+	MatlabTranslation* translation = createMatlabTranslation(model("2", "0.5", "10", "5").c_str(), NULL);
+	if (translation == NULL)
+	{
+		fail("the translation could not be created");
+		return 1;
+	}
+	if (translate(model("2", "0.5", "10", "5")) != getTranslationText(translation))
+	{
+		fail("the translation differs from the plain one");
+	}
+
+	// a value of every kind
+	const char* ids[] = { "k1", "S1", "X0", "cell" };
+	const double values[] = { 0.75, 3, 7.5, 4 };
+	if (updateTranslationValues(translation, 4, ids, values) != 0)
+	{
+		fail(string("the update was rejected: ") + getTranslationError(translation));
+	}
+	else if (translate(model("4", "0.75", "3", "7.5")) != getTranslationText(translation))
+	{
+		fail("the patched translation differs from a fresh one");
+	}
+
+	const double longer[] = { 0.123456, 1234.5, 0.001, 16 };
+	if (updateTranslationValues(translation, 4, ids, longer) != 0)
+	{
+		fail(string("the second update was rejected: ") + getTranslationError(translation));
+	}
+	else if (translate(model("16", "0.123456", "1234.5", "0.001")) != getTranslationText(translation))
+	{
+		fail("the translation patched twice differs from a fresh one");
+	}
+
+	// rejected updates leave the text as it was
+	string before = getTranslationText(translation);
+	const char* unknown[] = { "k1", "nothing" };
+	const double unknownValues[] = { 1, 1 };
+	if (updateTranslationValues(translation, 2, unknown, unknownValues) != -1 || string(getTranslationError(translation)).empty())
+	{
+		fail("an unknown id was accepted");
+	}
+	const char* volume[] = { "cell" };
+	const double unitVolume[] = { 1 };
+	if (updateTranslationValues(translation, 1, volume, unitVolume) != -1)
+	{
+		fail("a unit volume was accepted");
+	}
+	if (before != getTranslationText(translation))
+	{
+		fail("a rejected update changed the translation");
+	}
+
+	freeMatlabTranslation(translation);
+	return failures == 0 ? 0 : 1;
+}
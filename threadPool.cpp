@@ -0,0 +1,254 @@
+/* Filename    : threadPool.cpp
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the University of Washington nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "threadPool.h"
+
+using namespace std;
+
+// the pool and queue the current thread works for, if any
+static thread_local ThreadPool* currentPool = NULL;
+static thread_local size_t currentQueue = 0;
+
+int ThreadPool::processorCount()
+{
+	int count = (int) thread::hardware_concurrency();
+	return count > 0 ? count : 1;
+}
+
+ThreadPool::ThreadPool(int numThreads)
+  : _queues()
+  , _threads()
+  , _queued(0)
+  , _running(0)
+  , _nextQueue(0)
+  , _bStopping(false)
+{
+	if (numThreads <= 0)
+		numThreads = processorCount();
+	for (int i = 0; i < numThreads; i++)
+	{
+		_queues.push_back(new TQueue());
+	}
+	for (int i = 0; i < numThreads; i++)
+	{
+		_threads.push_back(thread(&ThreadPool::work, this, (size_t) i));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		lock_guard<mutex> lock(_lock);
+		_bStopping = true;
+	}
+	_wake.notify_all();
+	for (size_t i = 0; i < _threads.size(); i++)
+	{
+		_threads[i].join();
+	}
+	for (size_t i = 0; i < _queues.size(); i++)
+	{
+		delete _queues[i];
+	}
+}
+
+void ThreadPool::submit(const TTask& task)
+{
+	{
+		// the task is queued and counted in one go, so it is never taken
+		// before it is counted
+		lock_guard<mutex> lock(_lock);
+		size_t index = currentPool == this ? currentQueue : _nextQueue++ % _queues.size();
+		{
+			lock_guard<mutex> queueLock(_queues[index]->lock);
+			_queues[index]->tasks.push_back(task);
+		}
+		_queued++;
+	}
+	_wake.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	unique_lock<mutex> lock(_lock);
+	while (_queued > 0 || _running > 0)
+	{
+		_idle.wait(lock);
+	}
+}
+
+bool ThreadPool::take(size_t index, TTask& task)
+{
+	bool bTaken = false;
+	{
+		TQueue* own = _queues[index];
+		lock_guard<mutex> lock(own->lock);
+		if (!own->tasks.empty())
+		{
+			task = own->tasks.back();
+			own->tasks.pop_back();
+			bTaken = true;
+		}
+	}
+	for (size_t i = 1; !bTaken && i < _queues.size(); i++)
+	{
+		TQueue* victim = _queues[(index + i) % _queues.size()];
+		lock_guard<mutex> lock(victim->lock);
+		if (!victim->tasks.empty())
+		{
+			task = victim->tasks.front();
+			victim->tasks.pop_front();
+			bTaken = true;
+		}
+	}
+	if (bTaken)
+	{
+		lock_guard<mutex> lock(_lock);
+		_queued--;
+		_running++;
+	}
+	return bTaken;
+}
+
+bool ThreadPool::runOne(size_t index)
+{
+	TTask task;
+	if (!take(index, task))
+		return false;
+
+	try
+	{
+		task();
+	}
+	catch (...)
+	{
+	}
+	lock_guard<mutex> lock(_lock);
+	_running--;
+	if (_queued == 0 && _running == 0)
+		_idle.notify_all();
+	return true;
+}
+
+bool ThreadPool::runPending()
+{
+	return runOne(currentPool == this ? currentQueue : 0);
+}
+
+void ThreadPool::work(size_t index)
+{
+	currentPool = this;
+	currentQueue = index;
+	while (true)
+	{
+		if (runOne(index))
+			continue;
+
+		unique_lock<mutex> lock(_lock);
+		if (_queued > 0)
+			continue; // being taken by another worker right now, look again
+		if (_bStopping)
+			return;
+		_wake.wait(lock);
+	}
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool)
+  : _pool(pool)
+  , _pending(0)
+  , _error()
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+	try
+	{
+		wait();
+	}
+	catch (...)
+	{
+	}
+}
+
+void TaskGroup::run(const ThreadPool::TTask& task)
+{
+	{
+		lock_guard<mutex> lock(_lock);
+		_pending++;
+	}
+	_pool.submit(bind(&TaskGroup::runTask, this, task));
+}
+
+void TaskGroup::runTask(const ThreadPool::TTask& task)
+{
+	exception_ptr error;
+	try
+	{
+		task();
+	}
+	catch (...)
+	{
+		error = current_exception();
+	}
+	lock_guard<mutex> lock(_lock);
+	if (error && !_error)
+		_error = error;
+	if (--_pending == 0)
+		_done.notify_all();
+}
+
+void TaskGroup::wait()
+{
+	// help with the queued tasks, the group's own ones may be among them
+	while (true)
+	{
+		{
+			lock_guard<mutex> lock(_lock);
+			if (_pending == 0)
+				break;
+		}
+		if (!_pool.runPending())
+		{
+			// the rest is running on other threads
+			unique_lock<mutex> lock(_lock);
+			while (_pending > 0)
+			{
+				_done.wait(lock);
+			}
+			break;
+		}
+	}
+
+	exception_ptr error;
+	{
+		lock_guard<mutex> lock(_lock);
+		error = _error;
+		_error = exception_ptr();
+	}
+	if (error)
+		rethrow_exception(error);
+}
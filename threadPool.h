@@ -0,0 +1,144 @@
+/**
+* @file threadPool.h
+* @brief A work stealing thread pool for running translations side by side
+*
+*/
+
+/* 
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the University of Washington nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+/** @brief A fixed set of worker threads, each with a queue of its own
+*
+* Tasks submitted from outside the pool are dealt to the queues in turn,
+* tasks submitted by a running task go to the queue of its worker. A worker
+* takes the newest task of its own queue and, once that is empty, steals the
+* oldest task of another queue, so a long task never holds up the tasks
+* queued behind it.
+*/
+class ThreadPool
+{
+public:
+	typedef std::function<void()> TTask;
+
+	/** @brief Starts the workers
+	*
+	* @param[in] numThreads The number of workers, 0 or less for one per processor
+	*/
+	explicit ThreadPool(int numThreads);
+
+	/** @brief Runs the tasks still queued, then stops the workers
+	*/
+	~ThreadPool();
+
+	/** @brief Queues a task, tasks must not throw */
+	void submit(const TTask& task);
+
+	/** @brief Waits until every task submitted so far has run */
+	void wait();
+
+	/** @brief Runs one queued task on the calling thread, if there is one
+	*
+	* @return true if a task was run
+	*/
+	bool runPending();
+
+	/** @brief Returns the number of workers */
+	size_t size() const { return _threads.size(); }
+
+	/** @brief Returns the number of processors, at least 1 */
+	static int processorCount();
+
+private:
+	typedef struct {
+		std::mutex lock;
+		std::deque<TTask> tasks;
+	} TQueue;
+
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator=(const ThreadPool&);
+
+	void work(size_t index);
+	bool take(size_t index, TTask& task);
+	bool runOne(size_t index);
+
+	std::vector<TQueue*> _queues;
+	std::vector<std::thread> _threads;
+
+	std::mutex _lock; // guards the counters below
+	std::condition_variable _wake;
+	std::condition_variable _idle;
+	size_t _queued;
+	size_t _running;
+	size_t _nextQueue;
+	bool _bStopping;
+};
+
+/** @brief A set of related tasks on a pool that can be waited for on their own
+*
+* Unlike ThreadPool::wait, waiting for a group works from within a task of
+* the same pool: the waiting thread runs queued tasks until the group is
+* done. The first exception thrown by a task of the group is thrown again by
+* wait, the ones thrown after it are dropped.
+*/
+class TaskGroup
+{
+public:
+	explicit TaskGroup(ThreadPool& pool);
+
+	/** @brief Waits for the tasks still running */
+	~TaskGroup();
+
+	/** @brief Queues a task of the group */
+	void run(const ThreadPool::TTask& task);
+
+	/** @brief Waits until every task of the group has run */
+	void wait();
+
+private:
+	TaskGroup(const TaskGroup&);
+	TaskGroup& operator=(const TaskGroup&);
+
+	void runTask(const ThreadPool::TTask& task);
+
+	ThreadPool& _pool;
+	std::mutex _lock;
+	std::condition_variable _done;
+	size_t _pending;
+	std::exception_ptr _error;
+};
+
+#endif
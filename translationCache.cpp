@@ -0,0 +1,433 @@
+/* Filename    : translationCache.cpp
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the University of Washington nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "translationCache.h"
+#include "contentHash.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#include <algorithm>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+// the type test macros are missing from the Windows headers
+#if defined(WIN32) && !defined(S_ISREG)
+#define S_ISREG(mode) (((mode) & S_IFMT) == S_IFREG)
+#define S_ISDIR(mode) (((mode) & S_IFMT) == S_IFDIR)
+#endif
+
+#ifdef WIN32
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#include <sys/utime.h>
+#define getpid _getpid
+#else
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+using namespace std;
+
+// first line of every entry, followed by the length of the translation
+static const char* CACHE_MAGIC = "sbml2matlab-cache";
+static const char* CACHE_SUFFIX = ".m";
+static const char* TEMP_SUFFIX = ".tmp";
+
+// temporary files older than this are left overs of crashed writers
+static const time_t STALE_TEMP_SECONDS = 3600;
+
+map<string, TranslationCache*> TranslationCache::_caches;
+mutex TranslationCache::_cachesMutex;
+
+typedef struct {
+	string name;
+	unsigned long long size;
+	time_t modified;
+} TCacheFile;
+
+static bool olderFirst(const TCacheFile& a, const TCacheFile& b)
+{
+	return a.modified < b.modified;
+}
+
+static bool endsWith(const string& str, const string& suffix)
+{
+	return str.length() >= suffix.length()
+		&& str.compare(str.length() - suffix.length(), suffix.length(), suffix) == 0;
+}
+
+// lists the regular files in a directory
+static void listFiles(const string& directory, vector<TCacheFile>& files)
+{
+#ifdef WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE handle = FindFirstFileA((directory + "\\*").c_str(), &data);
+	if (handle == INVALID_HANDLE_VALUE) return;
+	do
+	{
+		if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+		TCacheFile file;
+		file.name = data.cFileName;
+		file.size = ((unsigned long long) data.nFileSizeHigh << 32) | data.nFileSizeLow;
+		ULARGE_INTEGER time;
+		time.LowPart = data.ftLastWriteTime.dwLowDateTime;
+		time.HighPart = data.ftLastWriteTime.dwHighDateTime;
+		file.modified = (time_t) ((time.QuadPart - 116444736000000000ULL) / 10000000ULL);
+		files.push_back(file);
+	} while (FindNextFileA(handle, &data));
+	FindClose(handle);
+#else
+	DIR* dir = opendir(directory.c_str());
+	if (dir == NULL) return;
+	struct dirent* entry;
+	while ((entry = readdir(dir)) != NULL)
+	{
+		TCacheFile file;
+		file.name = entry->d_name;
+		struct stat info;
+		if (stat((directory + "/" + file.name).c_str(), &info) != 0 || !S_ISREG(info.st_mode)) continue;
+		file.size = (unsigned long long) info.st_size;
+		file.modified = info.st_mtime;
+		files.push_back(file);
+	}
+	closedir(dir);
+#endif
+}
+
+// renames over an existing file, which rename() does not do on Windows
+static bool replaceFile(const string& from, const string& to)
+{
+#ifdef WIN32
+	return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+TranslationCache* TranslationCache::open(const string& directory, unsigned long long maxBytes)
+{
+	lock_guard<mutex> lock(_cachesMutex);
+
+	map<string, TranslationCache*>::iterator it = _caches.find(directory);
+	if (it != _caches.end())
+	{
+		lock_guard<mutex> cacheLock(it->second->_mutex);
+		it->second->_maxBytes = maxBytes;
+		return it->second;
+	}
+
+#ifdef WIN32
+	_mkdir(directory.c_str());
+#else
+	mkdir(directory.c_str(), 0777);
+#endif
+	struct stat info;
+	if (stat(directory.c_str(), &info) != 0 || !S_ISDIR(info.st_mode))
+	{
+		fprintf(stderr, "Translation cache directory '%s' cannot be used\n", directory.c_str());
+		return NULL;
+	}
+
+	TranslationCache* cache = new TranslationCache(directory, maxBytes);
+	_caches[directory] = cache;
+	return cache;
+}
+
+string TranslationCache::makeKey(const string& sbml, const string& options)
+{
+	return makeKey(sbml.data(), sbml.length(), options);
+}
+
+string TranslationCache::makeKey(const char* sbml, size_t length, const string& options)
+{
+	TSha256 digest;
+	digest.update(options);
+	digest.update("\n", 1);
+	digest.update(sbml, length);
+	return digest.hexDigest();
+}
+
+TranslationCache::TranslationCache(const string& directory, unsigned long long maxBytes)
+  : _directory(directory)
+  , _maxBytes(maxBytes)
+  , _totalBytes(0)
+  , _scanned(false)
+  , _tempCounter(0)
+  , _mutex()
+{
+}
+
+string TranslationCache::entryPath(const string& key) const
+{
+	return _directory + "/" + key + CACHE_SUFFIX;
+}
+
+bool TranslationCache::lookup(const string& key, string& matlab)
+{
+	string path = entryPath(key);
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == NULL) return false;
+
+	char header[64];
+	unsigned long long length = 0;
+	bool bValid = fgets(header, sizeof(header), file) != NULL
+		&& sscanf(header, "sbml2matlab-cache %llu", &length) == 1;
+	if (bValid)
+	{
+		matlab.resize((size_t) length);
+		bValid = length == 0 || fread(&matlab[0], 1, (size_t) length, file) == length;
+	}
+	fclose(file);
+
+	if (!bValid)
+	{
+		// a damaged entry is dropped so the next store replaces it
+		remove(path.c_str());
+		matlab.clear();
+		return false;
+	}
+
+	// refresh the entry for the least recently used eviction
+	utime(path.c_str(), NULL);
+	return true;
+}
+
+void TranslationCache::store(const string& key, const string& matlab)
+{
+	char tempName[64];
+	{
+		lock_guard<mutex> lock(_mutex);
+		sprintf(tempName, ".%d.%u", (int) getpid(), _tempCounter++);
+	}
+	string path = entryPath(key);
+	string tempPath = path + tempName + TEMP_SUFFIX;
+
+	FILE* file = fopen(tempPath.c_str(), "wb");
+	if (file == NULL) return;
+	int headerLength = fprintf(file, "%s %llu\n", CACHE_MAGIC, (unsigned long long) matlab.length());
+	bool bWritten = headerLength > 0
+		&& fwrite(matlab.data(), 1, matlab.length(), file) == matlab.length();
+	bWritten = (fclose(file) == 0) && bWritten;
+
+	if (!bWritten || !replaceFile(tempPath, path))
+	{
+		remove(tempPath.c_str());
+		return;
+	}
+
+	lock_guard<mutex> lock(_mutex);
+	if (_maxBytes > 0)
+	{
+		if (!_scanned)
+			scan();
+		else
+			_totalBytes += headerLength + matlab.length();
+		if (_totalBytes > _maxBytes)
+			evict();
+	}
+}
+
+// the size of the directory is measured once per process and then tracked
+// as entries are added, other processes sharing the directory are picked
+// up again by the scan done in evict
+void TranslationCache::scan()
+{
+	vector<TCacheFile> files;
+	listFiles(_directory, files);
+
+	_totalBytes = 0;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		if (endsWith(files[i].name, CACHE_SUFFIX))
+			_totalBytes += files[i].size;
+	}
+	_scanned = true;
+}
+
+void TranslationCache::evict()
+{
+	vector<TCacheFile> files;
+	listFiles(_directory, files);
+
+	time_t now = time(NULL);
+	vector<TCacheFile> entries;
+	_totalBytes = 0;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		if (endsWith(files[i].name, CACHE_SUFFIX))
+		{
+			entries.push_back(files[i]);
+			_totalBytes += files[i].size;
+		}
+		else if (endsWith(files[i].name, TEMP_SUFFIX) && now - files[i].modified > STALE_TEMP_SECONDS)
+		{
+			remove((_directory + "/" + files[i].name).c_str());
+		}
+	}
+
+	// evict down to 90% of the cap so not every store has to evict again
+	unsigned long long target = _maxBytes - _maxBytes / 10;
+	sort(entries.begin(), entries.end(), olderFirst);
+	for (size_t i = 0; i < entries.size() && _totalBytes > target; i++)
+	{
+		if (remove((_directory + "/" + entries[i].name).c_str()) == 0)
+			_totalBytes -= entries[i].size;
+	}
+}
+
+// bookkeeping per entry on top of the strings themselves
+static const size_t ENTRY_OVERHEAD = 128;
+
+TranslationMemoryCache& TranslationMemoryCache::instance()
+{
+	static TranslationMemoryCache cache;
+	return cache;
+}
+
+TranslationMemoryCache::TranslationMemoryCache()
+  : _entries()
+  , _index()
+  , _maxBytes(0)
+  , _totalBytes(0)
+  , _hits(0)
+  , _misses(0)
+  , _mutex()
+{
+}
+
+unsigned long long TranslationMemoryCache::hash(const char* sbml, size_t length, const string& options) const
+{
+	return fnv1a64(sbml, length, fnv1a64(options.data(), options.length()));
+}
+
+void TranslationMemoryCache::setMaxBytes(size_t maxBytes)
+{
+	lock_guard<mutex> lock(_mutex);
+	_maxBytes = maxBytes;
+	evict();
+}
+
+bool TranslationMemoryCache::enabled()
+{
+	lock_guard<mutex> lock(_mutex);
+	return _maxBytes > 0;
+}
+
+shared_ptr<const string> TranslationMemoryCache::lookup(const char* sbml, size_t length, const string& options)
+{
+	unsigned long long key = hash(sbml, length, options);
+
+	lock_guard<mutex> lock(_mutex);
+	pair<unordered_multimap<unsigned long long, TEntryList::iterator>::iterator,
+		unordered_multimap<unsigned long long, TEntryList::iterator>::iterator> range = _index.equal_range(key);
+	for (; range.first != range.second; ++range.first)
+	{
+		TEntryList::iterator entry = range.first->second;
+		if (entry->sbml.length() == length && entry->options == options
+			&& memcmp(entry->sbml.data(), sbml, length) == 0)
+		{
+			_entries.splice(_entries.begin(), _entries, entry);
+			_hits++;
+			return entry->matlab;
+		}
+	}
+	_misses++;
+	return shared_ptr<const string>();
+}
+
+void TranslationMemoryCache::store(const char* sbml, size_t length, const string& options, const string& matlab)
+{
+	unsigned long long key = hash(sbml, length, options);
+	size_t bytes = length + options.length() + matlab.length() + ENTRY_OVERHEAD;
+
+	lock_guard<mutex> lock(_mutex);
+	if (bytes > _maxBytes) return;
+
+	// another thread may have stored the same translation meanwhile
+	pair<unordered_multimap<unsigned long long, TEntryList::iterator>::iterator,
+		unordered_multimap<unsigned long long, TEntryList::iterator>::iterator> range = _index.equal_range(key);
+	for (; range.first != range.second; ++range.first)
+	{
+		TEntryList::iterator entry = range.first->second;
+		if (entry->sbml.length() == length && entry->options == options
+			&& memcmp(entry->sbml.data(), sbml, length) == 0)
+		{
+			return;
+		}
+	}
+
+	TEntry entry;
+	entry.hash = key;
+	entry.sbml.assign(sbml, length);
+	entry.options = options;
+	entry.matlab = make_shared<const string>(matlab);
+	entry.bytes = bytes;
+	_entries.push_front(entry);
+	_index.insert(make_pair(key, _entries.begin()));
+	_totalBytes += bytes;
+	evict();
+}
+
+// drops the least recently used entries until the cache fits its cap
+void TranslationMemoryCache::evict()
+{
+	while (_totalBytes > _maxBytes && !_entries.empty())
+	{
+		TEntryList::iterator last = --_entries.end();
+		pair<unordered_multimap<unsigned long long, TEntryList::iterator>::iterator,
+			unordered_multimap<unsigned long long, TEntryList::iterator>::iterator> range = _index.equal_range(last->hash);
+		for (; range.first != range.second; ++range.first)
+		{
+			if (range.first->second == last)
+			{
+				_index.erase(range.first);
+				break;
+			}
+		}
+		_totalBytes -= last->bytes;
+		_entries.erase(last);
+	}
+}
+
+void TranslationMemoryCache::clear()
+{
+	lock_guard<mutex> lock(_mutex);
+	_entries.clear();
+	_index.clear();
+	_totalBytes = 0;
+}
+
+void TranslationMemoryCache::getStats(unsigned long* hits, unsigned long* misses, size_t* bytes)
+{
+	lock_guard<mutex> lock(_mutex);
+	if (hits != NULL) *hits = _hits;
+	if (misses != NULL) *misses = _misses;
+	if (bytes != NULL) *bytes = _totalBytes;
+}
@@ -0,0 +1,169 @@
+/**
+* @file translationCache.h
+* @brief Persistent on-disk and in-process caches of translated models
+*
+*/
+
+/* 
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the University of Washington nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
+
+#ifndef TRANSLATION_CACHE_H
+#define TRANSLATION_CACHE_H
+
+#include <string>
+#include <map>
+#include <list>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+
+/** @brief Content addressed cache of translations kept in a directory
+*
+* Every entry is a file named after the hash of the SBML input, the
+* translator options and the translator version, so the directory can be
+* shared by any number of processes. Entries are written to a temporary file
+* and renamed into place, and a hit refreshes the modification time of the
+* entry, which is what the least recently used eviction goes by.
+*/
+class TranslationCache
+{
+public:
+	/** @brief Returns the cache for the given directory, creating it on first use
+	*
+	* @param[in] directory The cache directory, created if it does not exist
+	* @param[in] maxBytes The size the directory is kept under, 0 for no limit
+	* @return the cache, or NULL if the directory cannot be used
+	*/
+	static TranslationCache* open(const std::string& directory, unsigned long long maxBytes);
+
+	/** @brief Computes the key of a translation
+	*
+	* @param[in] sbml The SBML input
+	* @param[in] options A description of every option that changes the output
+	*/
+	static std::string makeKey(const std::string& sbml, const std::string& options);
+
+	/** @brief Computes the key of a translation from input that is not held by a string
+	*
+	* @param[in] sbml The SBML input
+	* @param[in] length The length of the SBML input
+	* @param[in] options A description of every option that changes the output
+	*/
+	static std::string makeKey(const char* sbml, size_t length, const std::string& options);
+
+	/** @brief Looks up a translation
+	*
+	* @param[in] key The key returned by makeKey
+	* @param[out] matlab The stored translation on a hit
+	* @return true on a hit
+	*/
+	bool lookup(const std::string& key, std::string& matlab);
+
+	/** @brief Stores a translation, evicting the least recently used entries when over the size cap
+	*/
+	void store(const std::string& key, const std::string& matlab);
+
+private:
+	TranslationCache(const std::string& directory, unsigned long long maxBytes);
+
+	std::string entryPath(const std::string& key) const;
+	void scan();
+	void evict();
+
+	std::string			_directory;
+	unsigned long long	_maxBytes;
+	unsigned long long	_totalBytes;
+	bool				_scanned;
+	unsigned int		_tempCounter;
+	std::mutex			_mutex;
+
+	static std::map<std::string, TranslationCache*> _caches;
+	static std::mutex	_cachesMutex;
+};
+
+/** @brief In-process least recently used cache of translations
+*
+* Consulted by the C API so repeated requests for the same model cost a hash
+* and a copy. Entries are keyed by a fast hash of the SBML input and the
+* options, and the full input is compared on a match. The cache is disabled
+* until it is given a size.
+*/
+class TranslationMemoryCache
+{
+public:
+	/** @brief Returns the process wide cache */
+	static TranslationMemoryCache& instance();
+
+	/** @brief Sets the memory cap in bytes, 0 disables the cache and drops all entries */
+	void setMaxBytes(size_t maxBytes);
+
+	/** @brief Returns true if the cache has been given a size */
+	bool enabled();
+
+	/** @brief Looks up a translation
+	*
+	* @param[in] sbml The SBML input
+	* @param[in] length The length of the SBML input
+	* @param[in] options A description of every option that changes the output
+	* @return the stored translation, or an empty pointer on a miss
+	*/
+	std::shared_ptr<const std::string> lookup(const char* sbml, size_t length, const std::string& options);
+
+	/** @brief Stores a translation, evicting the least recently used entries when over the cap */
+	void store(const char* sbml, size_t length, const std::string& options, const std::string& matlab);
+
+	/** @brief Drops all entries, the counters are kept */
+	void clear();
+
+	/** @brief Returns the hit and miss counters and the bytes held by the cache */
+	void getStats(unsigned long* hits, unsigned long* misses, size_t* bytes);
+
+private:
+	typedef struct {
+		unsigned long long hash;
+		std::string sbml;
+		std::string options;
+		std::shared_ptr<const std::string> matlab;
+		size_t bytes;
+	} TEntry;
+
+	typedef std::list<TEntry> TEntryList;
+
+	TranslationMemoryCache();
+
+	unsigned long long hash(const char* sbml, size_t length, const std::string& options) const;
+	void evict();
+
+	TEntryList			_entries; // most recently used first
+	std::unordered_multimap<unsigned long long, TEntryList::iterator> _index;
+	size_t				_maxBytes;
+	size_t				_totalBytes;
+	unsigned long		_hits;
+	unsigned long		_misses;
+	std::mutex			_mutex;
+};
+
+#endif
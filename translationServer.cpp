@@ -0,0 +1,469 @@
+/* Filename    : translationServer.cpp
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the University of Washington nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "translationServer.h"
+#include "workerPool.h"
+#include "threadPool.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <system_error>
+#include <algorithm>
+
+#ifndef WIN32
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+#endif
+
+using namespace std;
+
+#ifndef WIN32
+
+// frames larger than this are taken for a broken or foreign client
+static const unsigned int MAX_FRAME_BYTES = 1024u * 1024u * 1024u;
+
+// frames are read this much at a time, so the buffer only grows with the
+// bytes that actually arrive and not with the length a client claims
+static const size_t FRAME_CHUNK_BYTES = 64 * 1024;
+
+// a server serves this many connections at once, the ones after them wait
+// in the backlog of the socket until one ends
+static const int MAX_CONNECTIONS = 64;
+
+// the models of all connections together a server holds at once, a request
+// is only read once the bytes it announces fit; a single frame always fits
+static const unsigned long long MAX_BUFFERED_BYTES = 2ull * MAX_FRAME_BYTES;
+
+// the options of a request are a few short lines
+static const unsigned int MAX_OPTIONS_BYTES = 64 * 1024;
+
+// only the options that differ from the defaults are sent
+string encodeOptions(const TranslationOptions& options)
+{
+	TranslationOptions defaults;
+	initTranslationOptions(&defaults);
+	stringstream encoded;
+	if (options.validation != defaults.validation)
+		encoded << "validation=" << options.validation << "\n";
+	if (options.validationThreads != defaults.validationThreads)
+		encoded << "validationThreads=" << options.validationThreads << "\n";
+	if (options.emitThreads != defaults.emitThreads)
+		encoded << "emitThreads=" << options.emitThreads << "\n";
+	if (options.cacheDirectory != NULL && *options.cacheDirectory != '\0')
+		encoded << "cacheDirectory=" << options.cacheDirectory << "\n";
+	if (options.cacheMaxMegabytes != defaults.cacheMaxMegabytes)
+		encoded << "cacheMaxMegabytes=" << options.cacheMaxMegabytes << "\n";
+	return encoded.str();
+}
+
+bool decodeOptions(const string& encoded, TranslationOptions& options, string& cacheDirectory)
+{
+	initTranslationOptions(&options);
+	stringstream lines(encoded);
+	string line;
+	while (getline(lines, line))
+	{
+		size_t equals = line.find('=');
+		if (equals == string::npos)
+			return false;
+		string name = line.substr(0, equals);
+		string value = line.substr(equals + 1);
+		if (name == "validation")
+			options.validation = atoi(value.c_str());
+		else if (name == "validationThreads")
+			options.validationThreads = atoi(value.c_str());
+		else if (name == "emitThreads")
+			options.emitThreads = atoi(value.c_str());
+		else if (name == "cacheDirectory")
+			cacheDirectory = value;
+		else if (name == "cacheMaxMegabytes")
+			options.cacheMaxMegabytes = strtoul(value.c_str(), NULL, 10);
+		else
+			return false;
+	}
+	if (!cacheDirectory.empty())
+		options.cacheDirectory = cacheDirectory.c_str();
+	return true;
+}
+
+static bool readAll(int socket, char* data, size_t length)
+{
+	while (length > 0)
+	{
+		ssize_t received = recv(socket, data, length, 0);
+		if (received < 0 && errno == EINTR)
+			continue;
+		if (received <= 0)
+			return false;
+		data += received;
+		length -= (size_t) received;
+	}
+	return true;
+}
+
+static bool writeAll(int socket, const char* data, size_t length)
+{
+	while (length > 0)
+	{
+		ssize_t sent = send(socket, data, length, 0);
+		if (sent < 0 && errno == EINTR)
+			continue;
+		if (sent <= 0)
+			return false;
+		data += sent;
+		length -= (size_t) sent;
+	}
+	return true;
+}
+
+bool readWord(int socket, unsigned int& word)
+{
+	uint32_t networkWord;
+	if (!readAll(socket, (char*) &networkWord, sizeof(networkWord)))
+		return false;
+	word = ntohl(networkWord);
+	return true;
+}
+
+bool writeWord(int socket, unsigned int word)
+{
+	uint32_t networkWord = htonl(word);
+	return writeAll(socket, (const char*) &networkWord, sizeof(networkWord));
+}
+
+// reads the content of a frame whose length has been read already
+static bool readFrameContent(int socket, unsigned int length, string& frame)
+{
+	frame.clear();
+	while (frame.length() < length)
+	{
+		size_t received = frame.length();
+		size_t chunk = min((size_t) length - received, FRAME_CHUNK_BYTES);
+		frame.resize(received + chunk);
+		if (!readAll(socket, &frame[received], chunk))
+			return false;
+	}
+	return true;
+}
+
+bool readFrame(int socket, string& frame)
+{
+	unsigned int length;
+	return readWord(socket, length) && length <= MAX_FRAME_BYTES && readFrameContent(socket, length, frame);
+}
+
+bool writeFrame(int socket, const string& frame)
+{
+	return writeFrame(socket, frame.data(), frame.length());
+}
+
+bool writeFrame(int socket, const char* data, size_t length)
+{
+	return writeWord(socket, (unsigned int) length) && writeAll(socket, data, length);
+}
+
+static bool makeAddress(const string& socketPath, struct sockaddr_un& address)
+{
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (socketPath.length() >= sizeof(address.sun_path))
+		return false;
+	strcpy(address.sun_path, socketPath.c_str());
+	return true;
+}
+
+static int connectTo(const string& socketPath)
+{
+	struct sockaddr_un address;
+	if (!makeAddress(socketPath, address))
+		return -1;
+	int client = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (client < 0)
+		return -1;
+	if (connect(client, (struct sockaddr*) &address, sizeof(address)) != 0)
+	{
+		close(client);
+		return -1;
+	}
+	return client;
+}
+
+// the server decides where its cache lives and how many threads a request
+// may start, clients only choose the options that change the translation
+static void restrictOptions(TranslationOptions& options, const TranslationOptions* serverOptions)
+{
+	options.cacheDirectory = serverOptions != NULL ? serverOptions->cacheDirectory : NULL;
+	options.cacheMaxMegabytes = serverOptions != NULL ? serverOptions->cacheMaxMegabytes : 0;
+	int processors = ThreadPool::processorCount();
+	if (options.validationThreads < 0 || options.validationThreads > processors)
+		options.validationThreads = processors;
+	if (options.emitThreads < 0 || options.emitThreads > processors)
+		options.emitThreads = processors;
+}
+
+// what the connections of a server hold together, so a client can neither
+// start threads nor buffer models without bound
+class TServerBudget
+{
+public:
+	TServerBudget()
+		: _connections(0)
+		, _bytes(0)
+	{
+	}
+
+	// waits until another connection may be served
+	void enter()
+	{
+		unique_lock<mutex> lock(_lock);
+		while (_connections >= MAX_CONNECTIONS)
+		{
+			_freed.wait(lock);
+		}
+		_connections++;
+	}
+
+	void leave()
+	{
+		{
+			lock_guard<mutex> lock(_lock);
+			_connections--;
+		}
+		_freed.notify_all();
+	}
+
+	// waits until the given bytes fit; a connection holds one reservation at
+	// a time and only waits without one, so waiting cannot deadlock
+	void reserve(unsigned long long bytes)
+	{
+		unique_lock<mutex> lock(_lock);
+		while (_bytes + bytes > MAX_BUFFERED_BYTES)
+		{
+			_freed.wait(lock);
+		}
+		_bytes += bytes;
+	}
+
+	void release(unsigned long long bytes)
+	{
+		{
+			lock_guard<mutex> lock(_lock);
+			_bytes -= bytes;
+		}
+		_freed.notify_all();
+	}
+
+private:
+	mutex _lock;
+	condition_variable _freed;
+	int _connections;
+	unsigned long long _bytes;
+};
+
+// reads the options and the model of the next request; the model's bytes are
+// reserved before it is read, the caller releases them once it is answered
+static bool readRequest(int client, TServerBudget* budget, string& encodedOptions, string& sbml, unsigned int& length)
+{
+	unsigned int optionsLength;
+	if (!readWord(client, optionsLength) || optionsLength > MAX_OPTIONS_BYTES
+		|| !readFrameContent(client, optionsLength, encodedOptions)
+		|| !readWord(client, length) || length > MAX_FRAME_BYTES)
+		return false;
+	budget->reserve(length);
+	if (readFrameContent(client, length, sbml))
+		return true;
+	string().swap(sbml);
+	budget->release(length);
+	return false;
+}
+
+// answers the requests of one connection until the client hangs up
+static void serveConnection(int client, WorkerPool* workers, const TranslationOptions* serverOptions, TServerBudget* budget)
+{
+	string encodedOptions, sbml;
+	unsigned int length;
+	while (readRequest(client, budget, encodedOptions, sbml, length))
+	{
+		TranslationOptions options;
+		string cacheDirectory;
+		bool bAnswered;
+		if (!decodeOptions(encodedOptions, options, cacheDirectory))
+		{
+			bAnswered = writeWord(client, SERVER_BAD_REQUEST)
+				&& writeFrame(client, "")
+				&& writeFrame(client, "Unknown translation options");
+		}
+		else if (workers != NULL)
+		{
+			restrictOptions(options, serverOptions);
+			string output;
+			int status = workers->translate("", sbml.data(), sbml.length(), options, output);
+			string().swap(sbml);
+			bAnswered = writeWord(client, status)
+				&& writeFrame(client, status == SERVER_TRANSLATED ? output : "")
+				&& writeFrame(client, status == SERVER_TRANSLATED ? "" : output);
+		}
+		else
+		{
+			restrictOptions(options, serverOptions);
+			TranslationTicket* ticket = sbml2matlab_submit(sbml.c_str(), &options, NULL, NULL);
+			string().swap(sbml);
+			const char* matlab = NULL;
+			const char* error = NULL;
+			int status = sbml2matlab_wait(ticket, &matlab, &error);
+			bAnswered = writeWord(client, status == 0 ? SERVER_TRANSLATED : SERVER_NOT_TRANSLATED)
+				&& writeFrame(client, matlab != NULL ? matlab : "")
+				&& writeFrame(client, error != NULL ? error : "");
+			sbml2matlab_release(ticket);
+		}
+		string().swap(sbml);
+		budget->release(length);
+		if (!bAnswered)
+			break;
+	}
+	close(client);
+	budget->leave();
+}
+
+int serveTranslations(const string& socketPath, WorkerPool* workers, const TranslationOptions* serverOptions)
+{
+	struct sockaddr_un address;
+	if (!makeAddress(socketPath, address))
+	{
+		fprintf(stderr, "Socket name '%s' is too long\n", socketPath.c_str());
+		return -1;
+	}
+
+	// a socket nobody answers on was left behind by a server that died
+	int running = connectTo(socketPath);
+	if (running >= 0)
+	{
+		close(running);
+		fprintf(stderr, "A server is running on '%s' already\n", socketPath.c_str());
+		return -1;
+	}
+	unlink(socketPath.c_str());
+
+	// only the user running the server may connect, the socket is created
+	// without access for anybody else instead of being restricted after bind
+	int server = socket(AF_UNIX, SOCK_STREAM, 0);
+	mode_t mask = umask(0077);
+	bool bBound = server >= 0 && bind(server, (struct sockaddr*) &address, sizeof(address)) == 0;
+	umask(mask);
+	if (!bBound || chmod(socketPath.c_str(), 0600) != 0 || listen(server, SOMAXCONN) != 0)
+	{
+		fprintf(stderr, "Cannot serve on '%s': %s\n", socketPath.c_str(), strerror(errno));
+		if (server >= 0)
+			close(server);
+		return -1;
+	}
+
+	// a client hanging up before its answer is written must not end the server
+	signal(SIGPIPE, SIG_IGN);
+	// never freed, the detached connection threads may outlive this function
+	TServerBudget& budget = *new TServerBudget();
+	while (true)
+	{
+		budget.enter();
+		int client = accept(server, NULL, NULL);
+		if (client < 0)
+		{
+			budget.leave();
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			fprintf(stderr, "Cannot accept connections on '%s': %s\n", socketPath.c_str(), strerror(errno));
+			break;
+		}
+		try
+		{
+			thread(serveConnection, client, workers, serverOptions, &budget).detach();
+		}
+		catch (system_error&)
+		{
+			// no thread to spare, the client can try again
+			close(client);
+			budget.leave();
+		}
+	}
+	close(server);
+	unlink(socketPath.c_str());
+	return -1;
+}
+
+bool requestTranslation(const string& socketPath, const string& sbml, const TranslationOptions& options,
+	int& status, string& matlab, string& error)
+{
+	int server = connectTo(socketPath);
+	if (server < 0)
+	{
+		error = "Cannot connect to the translation server on '" + socketPath + "'";
+		return false;
+	}
+	signal(SIGPIPE, SIG_IGN);
+
+	unsigned int answer = SERVER_BAD_REQUEST;
+	bool bAnswered = writeFrame(server, encodeOptions(options))
+		&& writeFrame(server, sbml)
+		&& readWord(server, answer)
+		&& readFrame(server, matlab)
+		&& readFrame(server, error);
+	close(server);
+	if (!bAnswered)
+	{
+		error = "The translation server on '" + socketPath + "' broke off the connection";
+		return false;
+	}
+	status = (int) answer;
+	return true;
+}
+
+#else
+
+int serveTranslations(const string& socketPath, WorkerPool* workers, const TranslationOptions* serverOptions)
+{
+	fprintf(stderr, "Serving translations needs Unix domain sockets, which this platform does not have\n");
+	return -1;
+}
+
+bool requestTranslation(const string& socketPath, const string& sbml, const TranslationOptions& options,
+	int& status, string& matlab, string& error)
+{
+	error = "Translation servers need Unix domain sockets, which this platform does not have";
+	return false;
+}
+
+#endif
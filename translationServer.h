@@ -0,0 +1,125 @@
+/**
+* @file translationServer.h
+* @brief A long running translation server on a Unix domain socket and its client
+*
+*/
+
+/* 
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the University of Washington nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
+
+#ifndef TRANSLATION_SERVER_H
+#define TRANSLATION_SERVER_H
+
+#include <string>
+#include "sbml2matlab.h"
+
+/*
+* The protocol: every request and response is made of frames, a frame being
+* a 32 bit length in network byte order followed by that many bytes.
+*
+* request:  [options frame] [SBML frame]
+* response: [32 bit status] [MATLAB frame] [error frame]
+*
+* The options frame holds one "name=value" line per option that differs
+* from the defaults (validation, validationThreads, emitThreads,
+* cacheDirectory, cacheMaxMegabytes). A connection may carry any number of
+* requests one after another. A server ignores the cache options of its
+* clients in favor of its own, and limits the thread counts to the number
+* of processors.
+*/
+
+/** @brief Status of a translation answered by the server */
+enum TServerStatus
+{
+	SERVER_TRANSLATED = 0,    /**< The MATLAB frame holds the translation */
+	SERVER_NOT_TRANSLATED = 1,/**< The model could not be translated, the error frame tells why */
+	SERVER_BAD_REQUEST = 2,   /**< The request could not be read */
+	SERVER_CRASHED = 3,       /**< The worker process translating the model died */
+	SERVER_TIMED_OUT = 4,     /**< The translation was aborted, it took longer than the wall clock limit */
+	SERVER_CPU_LIMIT = 5,     /**< The translation was aborted, it used more than the CPU time limit */
+	SERVER_MEMORY_LIMIT = 6   /**< The translation was aborted, it needed more than the memory limit */
+};
+
+class WorkerPool;
+
+/** @brief Serves translations on a Unix domain socket until the process is stopped
+*
+* Every connection is served by a thread of its own, the translations run
+* on the pool of sbml2matlab_submit, so the translators stay warm between
+* requests, or in worker processes, so a model crashing its translator
+* fails only its own request. The socket is accessible to the user running
+* the server only. At most 64 connections are served at once, later ones
+* wait until one ends, and the models of all requests being served may
+* take at most 2 GB, a request waits to be read until its model fits.
+*
+* @param[in] socketPath The socket to create, a stale socket left by a server that died is replaced
+* @param[in] workers The worker processes to translate in, NULL to translate in this process
+* @param[in] serverOptions The options of the server, of which the cache directory and size are used for every request, may be NULL
+* @return -1 if the socket cannot be served
+*/
+int serveTranslations(const std::string& socketPath, WorkerPool* workers = NULL, const TranslationOptions* serverOptions = NULL);
+
+/** @brief Sends a translation to a server and waits for its answer
+*
+* @param[in] socketPath The socket of the server
+* @param[in] sbml The SBML to translate
+* @param[in] options The translation options
+* @param[out] status One of the TServerStatus values
+* @param[out] matlab The translation
+* @param[out] error Why the model could not be translated, or why the server could not be asked
+* @return false if the server could not be reached or broke off the answer
+*/
+bool requestTranslation(const std::string& socketPath, const std::string& sbml, const TranslationOptions& options,
+	int& status, std::string& matlab, std::string& error);
+
+/** @brief Writes a 32 bit word in network byte order, false if the peer is gone */
+bool writeWord(int socket, unsigned int word);
+
+/** @brief Reads a 32 bit word in network byte order, false if the peer is gone */
+bool readWord(int socket, unsigned int& word);
+
+/** @brief Writes a frame, false if the peer is gone */
+bool writeFrame(int socket, const std::string& frame);
+
+/** @brief Writes a frame from memory that is not held by a string, false if the peer is gone */
+bool writeFrame(int socket, const char* data, size_t length);
+
+/** @brief Reads a frame, false if the peer is gone or the frame is too large */
+bool readFrame(int socket, std::string& frame);
+
+/** @brief Returns the options frame for the given options */
+std::string encodeOptions(const TranslationOptions& options);
+
+/** @brief Reads an options frame
+*
+* @param[in] encoded The options frame
+* @param[out] options The options, the cache directory points into cacheDirectory
+* @param[out] cacheDirectory Holds the cache directory
+* @return false if the frame holds an unknown option
+*/
+bool decodeOptions(const std::string& encoded, TranslationOptions& options, std::string& cacheDirectory);
+
+#endif
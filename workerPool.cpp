@@ -0,0 +1,552 @@
+/* Filename    : workerPool.cpp
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the University of Washington nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "workerPool.h"
+#include "translationServer.h"
+#include "threadPool.h"
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <new>
+
+#ifndef WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#endif
+
+using namespace std;
+
+#ifndef WIN32
+
+// the socket a worker answers on, for the CPU limit handler
+static int answerSocket = -1;
+
+// whether the worker is translating, the CPU limit only ever aborts a
+// translation and never an answer being written
+static volatile sig_atomic_t bTranslating = 0;
+
+// the CPU limit was reached in the middle of a translation, which is
+// abandoned right here; sending is safe in a signal handler
+static void cpuLimitReached(int)
+{
+	if (!bTranslating)
+		return;
+	writeWord(answerSocket, SERVER_CPU_LIMIT);
+	writeWord(answerSocket, 0);
+	_exit(1);
+}
+
+// the memory limit of the worker in bytes and the size of a page, for the
+// crash handler, which cannot look them up itself
+static unsigned long long memoryLimit = 0;
+static unsigned long long pageSize = 4096;
+
+// the address space the worker uses, 0 if it cannot be told; only calls
+// that are safe in a signal handler
+static unsigned long long addressSpaceInUse()
+{
+	int file = open("/proc/self/statm", O_RDONLY);
+	if (file < 0)
+		return 0;
+	char text[64];
+	ssize_t length = read(file, text, sizeof(text));
+	close(file);
+	unsigned long long pages = 0;
+	for (ssize_t i = 0; i < length && text[i] >= '0' && text[i] <= '9'; i++)
+	{
+		pages = pages * 10 + (unsigned long long) (text[i] - '0');
+	}
+	return pages * pageSize;
+}
+
+// libSBML and libxml2 allocate with malloc, which returns NULL at the memory
+// limit, and the worker crashes soon after instead of throwing a bad_alloc;
+// a crash while the address space is within an eighth of the limit is
+// taken for the limit, any other crash takes its course and is reported
+// by the pool as a crash
+static void crashed(int number)
+{
+	unsigned long long inUse = addressSpaceInUse();
+	if (bTranslating && inUse > 0 && inUse >= memoryLimit - memoryLimit / 8)
+	{
+		writeWord(answerSocket, SERVER_MEMORY_LIMIT);
+		writeWord(answerSocket, 0);
+		_exit(1);
+	}
+	// the handler was reset, the signal ends the worker once this returns
+	raise(number);
+}
+
+// runs the crash handler on a stack of its own, the crash may have used up
+// the one of the translation
+static void catchCrashes()
+{
+	static char crashStack[64 * 1024];
+	stack_t stack;
+	stack.ss_sp = crashStack;
+	stack.ss_size = sizeof(crashStack);
+	stack.ss_flags = 0;
+	sigaltstack(&stack, NULL);
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = crashed;
+	action.sa_flags = SA_ONSTACK | SA_RESETHAND;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGSEGV, &action, NULL);
+	sigaction(SIGBUS, &action, NULL);
+	sigaction(SIGABRT, &action, NULL);
+}
+
+// only soft limits are moved, an unprivileged process cannot raise a hard
+// limit again once it is lowered
+static void setSoftLimit(int resource, rlim_t soft)
+{
+	struct rlimit limit;
+	if (getrlimit(resource, &limit) != 0)
+		return;
+	if (limit.rlim_max != RLIM_INFINITY && soft > limit.rlim_max)
+		soft = limit.rlim_max;
+	limit.rlim_cur = soft;
+	setrlimit(resource, &limit);
+}
+
+// the CPU limit counts the whole life of the worker, so every translation
+// gets its seconds on top of what the worker has used so far
+static void limitCpuTime(int cpuSeconds)
+{
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return;
+	// rlimits count whole seconds, the second begun is given on top
+	setSoftLimit(RLIMIT_CPU, (rlim_t) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + cpuSeconds + 1));
+}
+
+// answers the requests of the pool until it hangs up; the spawner and the
+// workers are forked copies of this process and never return into it
+static void runWorker(int socket, TWorkerTranslate translate, const TWorkerLimits& limits)
+{
+	answerSocket = socket;
+	if (limits.cpuSeconds > 0)
+		signal(SIGXCPU, cpuLimitReached);
+	if (limits.memoryMegabytes > 0)
+	{
+		memoryLimit = (unsigned long long) limits.memoryMegabytes * 1024 * 1024;
+		pageSize = (unsigned long long) sysconf(_SC_PAGESIZE);
+		catchCrashes();
+		setSoftLimit(RLIMIT_AS, (rlim_t) memoryLimit);
+	}
+
+	string encodedOptions, fileName, content;
+	while (readFrame(socket, encodedOptions) && readFrame(socket, fileName) && readFrame(socket, content))
+	{
+		TranslationOptions options;
+		string cacheDirectory, output;
+		int status = SERVER_BAD_REQUEST;
+		if (decodeOptions(encodedOptions, options, cacheDirectory))
+		{
+			if (limits.cpuSeconds > 0)
+				limitCpuTime(limits.cpuSeconds);
+			bTranslating = 1;
+			try
+			{
+				status = translate(fileName, content, options, output);
+			}
+			catch (bad_alloc&)
+			{
+				// whatever was half built is lost with the worker
+				writeWord(socket, SERVER_MEMORY_LIMIT);
+				writeWord(socket, 0);
+				_exit(1);
+			}
+			bTranslating = 0;
+			if (limits.cpuSeconds > 0)
+				setSoftLimit(RLIMIT_CPU, RLIM_INFINITY);
+		}
+		string().swap(content);
+		if (!writeWord(socket, status) || !writeFrame(socket, output))
+			break;
+	}
+	_exit(0);
+}
+
+// hands the socket of a new worker to the pool along with its process id,
+// a negative id without a socket if no worker could be forked
+static bool sendWorker(int channel, int socket, int pid)
+{
+	struct iovec data;
+	data.iov_base = &pid;
+	data.iov_len = sizeof(pid);
+	struct msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = &data;
+	message.msg_iovlen = 1;
+
+	char control[CMSG_SPACE(sizeof(int))];
+	if (socket >= 0)
+	{
+		memset(control, 0, sizeof(control));
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+		struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+		header->cmsg_level = SOL_SOCKET;
+		header->cmsg_type = SCM_RIGHTS;
+		header->cmsg_len = CMSG_LEN(sizeof(int));
+		memcpy(CMSG_DATA(header), &socket, sizeof(int));
+	}
+
+	ssize_t sent;
+	do
+		sent = sendmsg(channel, &message, 0);
+	while (sent < 0 && errno == EINTR);
+	return sent == (ssize_t) sizeof(pid);
+}
+
+static bool receiveWorker(int channel, int& socket, int& pid)
+{
+	struct iovec data;
+	data.iov_base = &pid;
+	data.iov_len = sizeof(pid);
+	char control[CMSG_SPACE(sizeof(int))];
+	struct msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = &data;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+
+	ssize_t received;
+	do
+		received = recvmsg(channel, &message, 0);
+	while (received < 0 && errno == EINTR);
+	if (received != (ssize_t) sizeof(pid) || pid < 0)
+		return false;
+	struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+	if (header == NULL || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS)
+		return false;
+	memcpy(&socket, CMSG_DATA(header), sizeof(int));
+	return true;
+}
+
+// the requests the pool sends to the spawner
+static const char SPAWN_WORKER = 'w';
+static const char REAP_WORKER = 'r';
+
+static bool receiveAll(int channel, char* data, size_t length)
+{
+	while (length > 0)
+	{
+		ssize_t received = recv(channel, data, length, 0);
+		if (received < 0 && errno == EINTR)
+			continue;
+		if (received <= 0)
+			return false;
+		data += received;
+		length -= (size_t) received;
+	}
+	return true;
+}
+
+// forks a worker for every spawn request of the pool, until the pool hangs
+// up; being single threaded, it can fork at any time, which the pool cannot;
+// a worker is only reaped once the pool says so, until then its process id
+// cannot be taken by another process and the pool can kill it safely
+static void runSpawner(int channel, TWorkerTranslate translate, const TWorkerLimits& limits)
+{
+	while (true)
+	{
+		char request;
+		if (!receiveAll(channel, &request, 1))
+			break;
+		if (request == REAP_WORKER)
+		{
+			int pid;
+			if (!receiveAll(channel, (char*) &pid, sizeof(pid)))
+				break;
+			while (waitpid(pid, NULL, 0) < 0 && errno == EINTR)
+				;
+			continue;
+		}
+
+		int sockets[2];
+		int pid = -1;
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0)
+		{
+			pid = fork();
+			if (pid == 0)
+			{
+				close(channel);
+				close(sockets[0]);
+				runWorker(sockets[1], translate, limits);
+			}
+			close(sockets[1]);
+			if (pid < 0)
+			{
+				close(sockets[0]);
+				sockets[0] = -1;
+			}
+		}
+		else
+		{
+			sockets[0] = -1;
+		}
+
+		bool bSent = sendWorker(channel, sockets[0], pid);
+		if (sockets[0] >= 0)
+			close(sockets[0]);
+		if (!bSent)
+			break;
+	}
+	_exit(0);
+}
+
+WorkerPool* WorkerPool::start(int numWorkers, const TWorkerLimits& limits, TWorkerTranslate translate, string& error)
+{
+	if (numWorkers <= 0)
+		numWorkers = ThreadPool::processorCount();
+
+	int channel[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, channel) != 0)
+	{
+		error = strerror(errno);
+		return NULL;
+	}
+	// output still buffered would be written again by the children
+	fflush(stdout);
+	fflush(stderr);
+	int pid = fork();
+	if (pid < 0)
+	{
+		error = strerror(errno);
+		close(channel[0]);
+		close(channel[1]);
+		return NULL;
+	}
+	if (pid == 0)
+	{
+		close(channel[0]);
+		runSpawner(channel[1], translate, limits);
+	}
+	close(channel[1]);
+
+	// a worker dying before it has read its request must not end this process
+	signal(SIGPIPE, SIG_IGN);
+	WorkerPool* pool = new WorkerPool(channel[0], numWorkers, limits);
+	for (size_t i = 0; i < pool->_workers.size(); i++)
+	{
+		if (!pool->spawn(pool->_workers[i]))
+		{
+			error = "cannot fork worker processes";
+			delete pool;
+			return NULL;
+		}
+	}
+	return pool;
+}
+
+WorkerPool::WorkerPool(int spawner, int numWorkers, const TWorkerLimits& limits)
+	: _spawner(spawner), _limits(limits)
+{
+	TWorker worker;
+	worker.pid = -1;
+	worker.socket = -1;
+	_workers.resize(numWorkers, worker);
+	for (size_t i = 0; i < _workers.size(); i++)
+	{
+		_idle.push_back(i);
+	}
+}
+
+// the workers and the spawner leave once their socket is closed
+WorkerPool::~WorkerPool()
+{
+	for (size_t i = 0; i < _workers.size(); i++)
+	{
+		if (_workers[i].socket >= 0)
+			close(_workers[i].socket);
+	}
+	close(_spawner);
+}
+
+bool WorkerPool::spawn(TWorker& worker)
+{
+	lock_guard<mutex> lock(_spawnLock);
+	char request = SPAWN_WORKER;
+	ssize_t sent;
+	do
+		sent = send(_spawner, &request, 1, 0);
+	while (sent < 0 && errno == EINTR);
+	return sent == 1 && receiveWorker(_spawner, worker.socket, worker.pid);
+}
+
+// tells which limit a translation went over
+static string describeAbort(int status, const TWorkerLimits& limits)
+{
+	char message[100];
+	if (status == SERVER_CPU_LIMIT)
+		sprintf(message, "aborted, it used more than %d seconds of CPU time", limits.cpuSeconds);
+	else if (status == SERVER_MEMORY_LIMIT)
+		sprintf(message, "aborted, it needed more than %lu MB of memory", limits.memoryMegabytes);
+	else
+		sprintf(message, "aborted, it did not finish within %d seconds", limits.wallSeconds);
+	return message;
+}
+
+// kills a worker that crashed or hung, a new one is spawned when it is needed next;
+// the spawner has not reaped the worker yet, so even a worker that exited
+// on its own still owns its process id and killing it cannot hit another
+// process; the spawner reaps it afterwards
+void WorkerPool::retire(TWorker& worker)
+{
+	if (worker.pid > 0)
+	{
+		kill(worker.pid, SIGKILL);
+		lock_guard<mutex> lock(_spawnLock);
+		char request[1 + sizeof(int)];
+		request[0] = REAP_WORKER;
+		memcpy(request + 1, &worker.pid, sizeof(int));
+		size_t length = 0;
+		while (length < sizeof(request))
+		{
+			ssize_t sent = send(_spawner, request + length, sizeof(request) - length, 0);
+			if (sent < 0 && errno == EINTR)
+				continue;
+			if (sent <= 0)
+				break;
+			length += (size_t) sent;
+		}
+	}
+	if (worker.socket >= 0)
+		close(worker.socket);
+	worker.pid = -1;
+	worker.socket = -1;
+}
+
+int WorkerPool::run(TWorker& worker, const string& options, const string& fileName, const char* content, size_t length, string& output)
+{
+	// a worker that died while it was idle is replaced, it was not this model that killed it
+	bool bSent = false;
+	for (int attempt = 0; attempt < 2 && !bSent; attempt++)
+	{
+		if (worker.socket < 0 && !spawn(worker))
+			break;
+		bSent = writeFrame(worker.socket, options) && writeFrame(worker.socket, fileName) && writeFrame(worker.socket, content, length);
+		if (!bSent)
+			retire(worker);
+	}
+	if (!bSent)
+	{
+		output = "no worker process could be started";
+		return SERVER_CRASHED;
+	}
+
+	if (_limits.wallSeconds > 0)
+	{
+		chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + chrono::seconds(_limits.wallSeconds);
+		struct pollfd answer;
+		answer.fd = worker.socket;
+		answer.events = POLLIN;
+		int ready;
+		do
+		{
+			long long remaining = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+			answer.revents = 0;
+			ready = poll(&answer, 1, (int) max(remaining, 0LL));
+		}
+		while (ready < 0 && errno == EINTR);
+		if (ready == 0)
+		{
+			retire(worker);
+			output = describeAbort(SERVER_TIMED_OUT, _limits);
+			return SERVER_TIMED_OUT;
+		}
+	}
+
+	unsigned int status;
+	if (!readWord(worker.socket, status) || !readFrame(worker.socket, output))
+	{
+		retire(worker);
+		output = "the translation crashed its worker process";
+		return SERVER_CRASHED;
+	}
+	if (status == SERVER_CPU_LIMIT || status == SERVER_MEMORY_LIMIT)
+	{
+		// the worker leaves after an aborted translation
+		retire(worker);
+		output = describeAbort(status, _limits);
+	}
+	return (int) status;
+}
+
+int WorkerPool::translate(const string& fileName, const char* content, size_t length, const TranslationOptions& options, string& output)
+{
+	size_t index;
+	{
+		unique_lock<mutex> lock(_lock);
+		while (_idle.empty())
+			_released.wait(lock);
+		index = _idle.back();
+		_idle.pop_back();
+	}
+
+	int status = run(_workers[index], encodeOptions(options), fileName, content, length, output);
+
+	{
+		lock_guard<mutex> lock(_lock);
+		_idle.push_back(index);
+	}
+	_released.notify_one();
+	return status;
+}
+
+#else
+
+WorkerPool* WorkerPool::start(int numWorkers, const TWorkerLimits& limits, TWorkerTranslate translate, string& error)
+{
+	error = "worker processes need fork, which this platform does not have";
+	return NULL;
+}
+
+WorkerPool::~WorkerPool()
+{
+}
+
+int WorkerPool::translate(const string& fileName, const char* content, size_t length, const TranslationOptions& options, string& output)
+{
+	output = "worker processes need fork, which this platform does not have";
+	return SERVER_CRASHED;
+}
+
+#endif
@@ -0,0 +1,126 @@
+/**
+* @file workerPool.h
+* @brief Translations in pre-forked worker processes, so a model crashing or hanging its translator fails on its own
+*
+*/
+
+/* 
+Copyright (c) 2012, Stanley Gu
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the University of Washington nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL STANLEY GU BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include "sbml2matlab.h"
+
+/** @brief Translates a model in a worker process
+*
+* @param[in] fileName The file the model was read from, empty if it was not read from a file
+* @param[in] content The model as read
+* @param[in] options The translation options
+* @param[out] output The translation, or the report of why the model could not be translated
+* @return SERVER_TRANSLATED or SERVER_NOT_TRANSLATED
+*/
+typedef int (*TWorkerTranslate)(const std::string& fileName, const std::string& content,
+	const TranslationOptions& options, std::string& output);
+
+/** @brief What a single translation may use before it is aborted, 0 for no limit */
+typedef struct {
+	int wallSeconds;               /**< Time until the answer, the worker is taken for hung after it */
+	int cpuSeconds;                /**< CPU time of the worker */
+	unsigned long memoryMegabytes; /**< Address space of the worker, libraries and earlier translations included */
+} TWorkerLimits;
+
+/** @brief A fixed number of worker processes reused from one translation to the next
+*
+* The workers are forked by a spawner process, which is forked when the pool
+* starts and stays single threaded, so workers can be replaced safely while
+* the threads of this process are running. A worker that dies, or whose
+* translation goes over one of the limits, is killed and replaced, and only
+* the translation it was working on fails. The CPU time and memory limits
+* are enforced with rlimits in the worker, the wall clock limit by the pool.
+* C allocations inside libSBML and libxml2 fail with NULL rather than with
+* an exception, so a worker that crashes while its address space is close
+* to the memory limit reports the limit, any other crash is reported as one.
+*/
+class WorkerPool
+{
+public:
+	/** @brief Starts the spawner and the workers
+	*
+	* Has to be called before this process starts any threads.
+	*
+	* @param[in] numWorkers The number of workers, 0 or less for one per processor
+	* @param[in] limits What a single translation may use
+	* @param[in] translate What the workers run for every model
+	* @param[out] error Why the workers cannot be started
+	* @return the pool, or NULL if the workers cannot be started
+	*/
+	static WorkerPool* start(int numWorkers, const TWorkerLimits& limits, TWorkerTranslate translate, std::string& error);
+
+	/** @brief Stops the workers and the spawner */
+	~WorkerPool();
+
+	/** @brief Translates a model in the next free worker, waiting for one if all are busy
+	*
+	* @param[in] fileName The file the model was read from, empty if it was not read from a file
+	* @param[in] content The model as read, sent to the worker as it is
+	* @param[in] length The length of the content
+	* @param[in] options The translation options
+	* @param[out] output The translation, the report of why the model could not be translated, or what happened to the worker
+	* @return one of the TServerStatus values
+	*/
+	int translate(const std::string& fileName, const char* content, size_t length,
+		const TranslationOptions& options, std::string& output);
+
+	/** @brief Returns the number of workers */
+	size_t size() const { return _workers.size(); }
+
+private:
+	typedef struct {
+		int pid;
+		int socket; // -1 until the worker is spawned
+	} TWorker;
+
+	WorkerPool(int spawner, int numWorkers, const TWorkerLimits& limits);
+	bool spawn(TWorker& worker);
+	void retire(TWorker& worker);
+	int run(TWorker& worker, const std::string& options, const std::string& fileName, const char* content, size_t length, std::string& output);
+
+	int _spawner;
+	TWorkerLimits _limits;
+	std::vector<TWorker> _workers;
+	std::vector<size_t> _idle; // the workers not translating
+
+	std::mutex _lock;
+	std::condition_variable _released;
+	std::mutex _spawnLock;
+};
+
+#endif